@@ -0,0 +1,413 @@
+#ifndef AISDI_MAPS_ADAPTIVEMAP_H
+#define AISDI_MAPS_ADAPTIVEMAP_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "Hash.h"
+#include "HashMap.h"
+#include "InlineEntries.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+/*
+ * A map for unknown sizes - most stay tiny, a few grow huge. Up to InlineCapacity entries live
+ * in an array inside the object and are searched linearly (no allocation at all, one or two cache lines),
+ * the entry past that moves them all into a HashMap on the heap. Once removals shrink the table
+ * to InlineCapacity / 2 entries it is moved back inline - half, not the full capacity, so that a map
+ * going back and forth around the limit does not rebuild the table on every operation.
+ *
+ * Iteration order is unspecified (insertion order with holes filled by the last entry while inline,
+ * HashMap order after promotion). Every insertion and removal may change the representation
+ * and so invalidates iterators and references to values.
+ */
+template <typename KeyType, typename ValueType, std::size_t InlineCapacity = 8,
+          typename Hash = aisdi::Hash<KeyType>, typename KeyEqual = aisdi::EqualTo<KeyType>>
+class AdaptiveMap : private InlineEntries<std::pair<const KeyType, ValueType>, InlineCapacity>
+{
+  static_assert(InlineCapacity > 0, "AdaptiveMap needs room for at least one inline entry");
+
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using Table = HashMap<KeyType, ValueType, Hash, KeyEqual>;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  AdaptiveMap()
+  {}
+
+  AdaptiveMap(std::initializer_list<value_type> list) : AdaptiveMap()
+  {
+    for(auto element : list)
+      operator[](element.first) = element.second;
+  }
+
+  AdaptiveMap(const AdaptiveMap& other)
+    : Inline(other), table(other.table != nullptr ? new Table(*other.table) : nullptr)
+  {}
+
+  AdaptiveMap(AdaptiveMap&& other) : AdaptiveMap()
+  {
+    takeFrom(other);
+  }
+
+  AdaptiveMap& operator=(AdaptiveMap other)
+  {
+    this->clearInline();
+    table.reset();
+    takeFrom(other);
+    return *this;
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  // true while the entries live inside the object
+  bool isInline() const
+  {
+    return table == nullptr;
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    if(table != nullptr)
+      return (*table)[key];
+    const size_type index = indexOf(key);
+    if(index != this->inlineCount)
+      return this->inlineItem(index).second;
+    if(this->inlineCount < InlineCapacity)
+      return this->emplaceInline(key, mapped_type{}).second;
+    promote();
+    return (*table)[key];
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    if(isEmpty())
+      throw std::out_of_range("map is empty");
+    const mapped_type* value = tryGet(key);
+    if(value == nullptr)
+      throw std::out_of_range("key does not exist");
+    return *value;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<mapped_type&>(static_cast<const AdaptiveMap*>(this)->valueOf(key));
+  }
+
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    if(table != nullptr)
+      return static_cast<const Table&>(*table).tryGet(key);
+    const size_type index = indexOf(key);
+    return index == this->inlineCount ? nullptr : &this->inlineItem(index).second;
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const AdaptiveMap*>(this)->tryGet(key));
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    if(table != nullptr)
+      return ConstIterator(static_cast<const Table&>(*table).find(key), *this);
+    return ConstIterator(indexOf(key), *this);
+  }
+
+  iterator find(const key_type& key)
+  {
+    return static_cast<const AdaptiveMap*>(this)->find(key);
+  }
+
+  void remove(const key_type& key)
+  {
+    if(isEmpty())
+      throw std::out_of_range("cannot remove, empty list");
+    if(table != nullptr) {
+      table->remove(key);
+      if(table->getSize() <= InlineCapacity / 2)
+        demote();
+      return;
+    }
+    const size_type index = indexOf(key);
+    if(index == this->inlineCount)
+      throw std::out_of_range("cannot remove, element does not exist");
+    this->removeInline(index); // the last entry fills the hole
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it == end())
+      throw std::out_of_range("cannot erase end");
+    remove(it->first);
+  }
+
+  size_type getSize() const
+  {
+    return table != nullptr ? table->getSize() : this->inlineCount;
+  }
+
+  // nothing while inline - the entries are a part of the object; the table and everything it owns after promotion
+  MemoryUsage memoryUsage() const
+  {
+    if(table == nullptr)
+      return MemoryUsage();
+    MemoryUsage usage = table->memoryUsage();
+    usage.addBlocks(1, sizeof(Table));
+    return usage;
+  }
+
+  bool operator==(const AdaptiveMap& other) const
+  {
+    if(getSize() != other.getSize())
+      return false;
+    for(const auto& element : other) {
+      const mapped_type* value = tryGet(element.first);
+      if(value == nullptr || *value != element.second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const AdaptiveMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return cbegin();
+  }
+
+  iterator end()
+  {
+    return cend();
+  }
+
+  const_iterator cbegin() const
+  {
+    if(table != nullptr)
+      return ConstIterator(static_cast<const Table&>(*table).cbegin(), *this);
+    return ConstIterator(0, *this);
+  }
+
+  const_iterator cend() const
+  {
+    if(table != nullptr)
+      return ConstIterator(static_cast<const Table&>(*table).cend(), *this);
+    return ConstIterator(this->inlineCount, *this);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  using Inline = InlineEntries<value_type, InlineCapacity>; // inlineCount is 0 once promoted
+
+  std::unique_ptr<Table> table; // nullptr while inline
+
+  // position of the key among the inline entries, inlineCount when it is missing
+  size_type indexOf(const key_type& key) const
+  {
+    for(size_type index = 0; index < this->inlineCount; index++)
+      if(key_equal{}(this->inlineItem(index).first, key))
+        return index;
+    return this->inlineCount;
+  }
+
+  void promote()
+  {
+    std::unique_ptr<Table> newTable(new Table);
+    for(size_type index = 0; index < this->inlineCount; index++)
+      (*newTable)[this->inlineItem(index).first] = std::move(this->inlineItem(index).second);
+    this->clearInline();
+    table = std::move(newTable);
+  }
+
+  void demote()
+  {
+    for(auto& element : *table)
+      this->emplaceInline(element.first, std::move(element.second));
+    table.reset();
+  }
+
+  // this has to be empty and inline, other is left so
+  void takeFrom(AdaptiveMap& other)
+  {
+    table = std::move(other.table);
+    for(size_type index = 0; index < other.inlineCount; index++)
+      this->emplaceInline(std::move(other.inlineItem(index)));
+    other.clearInline();
+  }
+};
+
+template <typename KeyType, typename ValueType, std::size_t InlineCapacity, typename Hash, typename KeyEqual>
+class AdaptiveMap<KeyType, ValueType, InlineCapacity, Hash, KeyEqual>::ConstIterator
+{
+public:
+  using reference = typename AdaptiveMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename AdaptiveMap::value_type;
+  using pointer = const typename AdaptiveMap::value_type*;
+
+  explicit ConstIterator() : index(0), position(), map(nullptr)
+  {}
+
+  explicit ConstIterator(size_type index, const AdaptiveMap& map) : index(index), position(), map(&map)
+  {}
+
+  explicit ConstIterator(typename Table::const_iterator position, const AdaptiveMap& map)
+    : index(0), position(position), map(&map)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(map->table != nullptr)
+      ++position;
+    else if(index >= map->inlineCount)
+      throw std::out_of_range("cannot increment end");
+    else
+      index++;
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator old(*this);
+    operator++();
+    return old;
+  }
+
+  ConstIterator& operator--()
+  {
+    if(map->table != nullptr)
+      --position;
+    else if(index == 0)
+      throw std::out_of_range(map->inlineCount == 0 ? "cannot decrement begin, empty map" : "cannot decrement begin");
+    else
+      index--;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator old(*this);
+    operator--();
+    return old;
+  }
+
+  reference operator*() const
+  {
+    if(map->table != nullptr)
+      return *position;
+    if(index >= map->inlineCount)
+      throw std::out_of_range("cannot dereference end");
+    return map->inlineItem(index);
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return index == other.index && position == other.position;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  size_type index; // into the inline entries, inlineCount for end
+  typename Table::const_iterator position; // into the table once promoted
+  const AdaptiveMap *map;
+};
+
+template <typename KeyType, typename ValueType, std::size_t InlineCapacity, typename Hash, typename KeyEqual>
+class AdaptiveMap<KeyType, ValueType, InlineCapacity, Hash, KeyEqual>::Iterator
+  : public AdaptiveMap<KeyType, ValueType, InlineCapacity, Hash, KeyEqual>::ConstIterator
+{
+public:
+  using reference = typename AdaptiveMap::reference;
+  using pointer = typename AdaptiveMap::value_type*;
+
+  explicit Iterator()
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_ADAPTIVEMAP_H */
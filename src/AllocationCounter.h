@@ -0,0 +1,144 @@
+#ifndef AISDI_MAPS_ALLOCATIONCOUNTER_H
+#define AISDI_MAPS_ALLOCATIONCOUNTER_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/*
+ * Counts heap memory allocated by global operator new, for the benchmarks to report bytes per entry.
+ *
+ * Exactly one translation unit of a program has to define AISDI_DEFINE_ALLOCATION_COUNTER
+ * before including this header - it then replaces the global operator new and delete.
+ * Sizes are taken from malloc_usable_size() plus malloc's size_t chunk header - the footprint of a block
+ * in the heap, as estimated by mallocChunkBytes() for memoryUsage() of the maps. No bookkeeping header
+ * of our own is added to allocations (which would change the memory layout being measured).
+ * Without glibc nothing is counted and allocationCountingAvailable() is false.
+ * Counters are not atomic - the benchmark is single threaded.
+ */
+namespace aisdi
+{
+
+struct AllocationStats
+{
+  std::size_t liveBytes = 0;
+  std::size_t liveAllocations = 0;
+  std::size_t allocations = 0; // ever made
+};
+
+namespace detail
+{
+inline AllocationStats allocationStats;
+inline bool allocationCounterInstalled = false;
+}
+
+inline AllocationStats currentAllocations()
+{
+  return detail::allocationStats;
+}
+
+inline bool allocationCountingAvailable()
+{
+  return detail::allocationCounterInstalled;
+}
+
+}
+
+#endif /* AISDI_MAPS_ALLOCATIONCOUNTER_H */
+
+// outside of the include guard - the header may have been included before the macro was defined
+#if defined(AISDI_DEFINE_ALLOCATION_COUNTER) && defined(__GLIBC__) && !defined(AISDI_MAPS_ALLOCATIONCOUNTER_DEFINED)
+#define AISDI_MAPS_ALLOCATIONCOUNTER_DEFINED
+
+// Replacements are not inlined into their callers, as if they were linked in from elsewhere -
+// otherwise GCC sees free() of memory from operator new and warns (-Wmismatched-new-delete).
+#define AISDI_REPLACED_ALLOCATION __attribute__((noinline))
+
+namespace aisdi
+{
+namespace detail
+{
+
+inline void* countedAllocate(std::size_t size) noexcept
+{
+  void* pointer = std::malloc(size == 0 ? 1 : size);
+  if(pointer != nullptr) {
+    allocationStats.liveBytes += malloc_usable_size(pointer) + sizeof(std::size_t);
+    allocationStats.liveAllocations++;
+    allocationStats.allocations++;
+  }
+  return pointer;
+}
+
+inline void countedFree(void* pointer) noexcept
+{
+  if(pointer == nullptr)
+    return;
+  allocationStats.liveBytes -= malloc_usable_size(pointer) + sizeof(std::size_t);
+  allocationStats.liveAllocations--;
+  std::free(pointer);
+}
+
+const bool allocationCounterInstaller = (allocationCounterInstalled = true);
+
+}
+}
+
+AISDI_REPLACED_ALLOCATION void* operator new(std::size_t size)
+{
+  void* pointer = aisdi::detail::countedAllocate(size);
+  if(pointer == nullptr)
+    throw std::bad_alloc();
+  return pointer;
+}
+
+AISDI_REPLACED_ALLOCATION void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+AISDI_REPLACED_ALLOCATION void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return aisdi::detail::countedAllocate(size);
+}
+
+AISDI_REPLACED_ALLOCATION void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return aisdi::detail::countedAllocate(size);
+}
+
+AISDI_REPLACED_ALLOCATION void operator delete(void* pointer) noexcept
+{
+  aisdi::detail::countedFree(pointer);
+}
+
+AISDI_REPLACED_ALLOCATION void operator delete[](void* pointer) noexcept
+{
+  aisdi::detail::countedFree(pointer);
+}
+
+AISDI_REPLACED_ALLOCATION void operator delete(void* pointer, std::size_t) noexcept
+{
+  aisdi::detail::countedFree(pointer);
+}
+
+AISDI_REPLACED_ALLOCATION void operator delete[](void* pointer, std::size_t) noexcept
+{
+  aisdi::detail::countedFree(pointer);
+}
+
+AISDI_REPLACED_ALLOCATION void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+  aisdi::detail::countedFree(pointer);
+}
+
+AISDI_REPLACED_ALLOCATION void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+  aisdi::detail::countedFree(pointer);
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef AISDI_MAPS_ARRAYVIEW_H
+#define AISDI_MAPS_ARRAYVIEW_H
+
+#include <cstddef>
+#include <type_traits>
+
+namespace aisdi
+{
+
+/*
+ * Elements laid out one after another in memory, owned by someone else - std::span of C++20, for
+ * handing the keys or values of a map to a loop the compiler can vectorize. Valid until the owner changes.
+ */
+template <typename T>
+class ArrayView
+{
+public:
+  using element_type = T;
+  using value_type = typename std::remove_cv<T>::type;
+  using size_type = std::size_t;
+  using iterator = T*;
+
+  constexpr ArrayView() : first(nullptr), length(0)
+  {}
+
+  constexpr ArrayView(T* first, size_type length) : first(first), length(length)
+  {}
+
+  constexpr T* data() const
+  {
+    return first;
+  }
+
+  constexpr size_type size() const
+  {
+    return length;
+  }
+
+  constexpr bool empty() const
+  {
+    return length == 0;
+  }
+
+  constexpr T& operator[](size_type index) const
+  {
+    return first[index];
+  }
+
+  constexpr iterator begin() const
+  {
+    return first;
+  }
+
+  constexpr iterator end() const
+  {
+    return first + length;
+  }
+
+private:
+  T *first;
+  size_type length;
+};
+
+}
+
+#endif /* AISDI_MAPS_ARRAYVIEW_H */
@@ -0,0 +1,30 @@
+#ifndef AISDI_MAPS_ARROWPROXY_H
+#define AISDI_MAPS_ARROWPROXY_H
+
+namespace aisdi
+{
+
+/*
+ * The pointer type of iterators that dereference to a value (a pair of references, or a pair made
+ * on the fly) instead of a reference to an element - operator-> has to return something with
+ * operator->, so the value is kept in here.
+ */
+template <typename Reference>
+class ArrowProxy
+{
+public:
+  explicit ArrowProxy(const Reference& reference) : reference(reference)
+  {}
+
+  const Reference* operator->() const
+  {
+    return &reference;
+  }
+
+private:
+  Reference reference;
+};
+
+}
+
+#endif /* AISDI_MAPS_ARROWPROXY_H */
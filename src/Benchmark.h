@@ -0,0 +1,462 @@
+#ifndef AISDI_MAPS_BENCHMARK_H
+#define AISDI_MAPS_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "LatencyHistogram.h"
+#include "MemoryUsage.h"
+#include "PerfCounters.h"
+#include "Workload.h"
+
+namespace aisdi
+{
+
+struct Measurement
+{
+  std::string map;
+  std::string operation;
+  std::size_t size;
+  std::size_t repetitions;
+  double nsPerOperation; // mean of the measured repetitions
+  double stddev;
+  double bestNsPerOperation;
+  double operationsPerSecond;
+  double bytesPerEntry = 0; // heap bytes of the measured map per element, 0 when not counted
+  MemoryUsage memory; // as reported by the map itself, empty for maps without memoryUsage()
+  std::vector<std::pair<std::string, double>> counters; // hardware counters per operation, NaN when unavailable
+  LatencyHistogram latency; // ns per operation of timed batches, empty unless BenchmarkConfig::latencyBatch is set
+};
+
+struct BenchmarkConfig
+{
+  std::size_t warmups = 1;
+  std::size_t repetitions = 5;
+  PerfCounters* counters = nullptr; // when set, read around every measured run
+  std::size_t latencyBatch = 0; // operations per timed batch for latency histograms, 0 - no histograms
+};
+
+template <typename M, typename = void>
+struct HasMemoryUsage : std::false_type
+{};
+
+template <typename M>
+struct HasMemoryUsage<M, std::void_t<decltype(std::declval<const M&>().memoryUsage())>> : std::true_type
+{};
+
+template <typename M>
+MemoryUsage reportedMemoryUsage(const M& map)
+{
+  if constexpr(HasMemoryUsage<M>::value)
+    return map.memoryUsage();
+  else
+    return MemoryUsage();
+}
+
+/*
+ * Times run() config.repetitions times, each preceded by an untimed setup().
+ * The first config.warmups runs fill caches, fault in pages and train branch predictors
+ * and are thrown away. Times are reported per operation, noOperations being done by one run().
+ */
+template <typename Setup, typename Run>
+Measurement measure(const BenchmarkConfig& config, std::size_t noOperations, Setup setup, Run run)
+{
+  if(config.repetitions == 0 || noOperations == 0)
+    throw std::invalid_argument("nothing to measure");
+
+  std::vector<double> samples, counts;
+  for(std::size_t i = 0; i < config.warmups + config.repetitions; i++) {
+    const bool measured = i >= config.warmups;
+    setup();
+    if(measured && config.counters != nullptr)
+      config.counters->start();
+    const auto start = std::chrono::steady_clock::now();
+    run();
+    const auto stop = std::chrono::steady_clock::now();
+    if(!measured)
+      continue;
+    samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count() / noOperations);
+    if(config.counters != nullptr) {
+      const auto values = config.counters->stop();
+      counts.resize(values.size(), 0);
+      for(std::size_t j = 0; j < values.size(); j++)
+        counts[j] += values[j];
+    }
+  }
+
+  double sum = 0, best = samples.front();
+  for(double sample : samples) {
+    sum += sample;
+    best = sample < best ? sample : best;
+  }
+  const double mean = sum / samples.size();
+  double squares = 0;
+  for(double sample : samples)
+    squares += (sample - mean) * (sample - mean);
+
+  Measurement result;
+  result.size = 0;
+  result.repetitions = samples.size();
+  result.nsPerOperation = mean;
+  result.stddev = samples.size() > 1 ? std::sqrt(squares / (samples.size() - 1)) : 0;
+  result.bestNsPerOperation = best;
+  result.operationsPerSecond = 1e9 / mean;
+  if(config.counters != nullptr) {
+    const auto names = config.counters->names();
+    for(std::size_t j = 0; j < names.size(); j++)
+      result.counters.push_back({ names[j], counts[j] / (samples.size() * noOperations) });
+  }
+  return result;
+}
+
+/*
+ * Times noOperations calls of step(i) like measure() does. With config.latencyBatch set, then also times
+ * every batch of that many steps on its own (config.repetitions passes, each after setup()),
+ * recording nanoseconds per operation of each batch into result.latency.
+ */
+template <typename Setup, typename Step>
+Measurement measureSteps(const BenchmarkConfig& config, std::size_t noOperations, Setup setup, Step step)
+{
+  Measurement result = measure(config, noOperations, setup, [&]() {
+    for(std::size_t i = 0; i < noOperations; i++)
+      step(i);
+  });
+  if(config.latencyBatch == 0)
+    return result;
+
+  const double nanosecondsPerTick = CycleClock::nanosecondsPerTick();
+  for(std::size_t repetition = 0; repetition < config.repetitions; repetition++) {
+    setup();
+    for(std::size_t first = 0; first < noOperations; first += config.latencyBatch) {
+      const std::size_t last = std::min(noOperations, first + config.latencyBatch);
+      const std::uint64_t start = CycleClock::now();
+      for(std::size_t i = first; i < last; i++)
+        step(i);
+      const std::uint64_t ticks = CycleClock::now() - start;
+      result.latency.record(static_cast<std::uint64_t>(ticks * nanosecondsPerTick / (last - first) + 0.5));
+    }
+  }
+  return result;
+}
+
+/*
+ * Measures the requested operations on a map of keys.size() elements:
+ *   insert  - operator[] of every key into an empty map,
+ *   hit     - tryGet() of every key, in a different order than inserted,
+ *   miss    - tryGet() of missingKeys, none of which is in the map,
+ *   iterate - walk over the whole map,
+ *   remove  - remove() of every key from a full map,
+ *   copy    - copy construction of the full map (per element).
+ * Latencies are recorded for all but iterate and copy, which are not made of separate operations.
+ */
+template <typename M>
+void benchmarkMap(const std::string& name, const std::vector<typename M::key_type>& keys,
+                  const std::vector<typename M::key_type>& lookups,
+                  const std::vector<typename M::key_type>& missingKeys,
+                  const std::vector<std::string>& operations, const BenchmarkConfig& config,
+                  std::vector<Measurement>& results)
+{
+  const std::size_t bytesBefore = currentAllocations().liveBytes;
+  M map;
+  for(const auto& key : keys)
+    map[key] = typename M::mapped_type();
+  const double bytesPerEntry = keys.empty() ? 0 : double(currentAllocations().liveBytes - bytesBefore) / keys.size();
+  const MemoryUsage memory = reportedMemoryUsage(map);
+
+  std::unique_ptr<M> scratch;
+  std::size_t found = 0;
+  volatile std::size_t sink = 0;
+  const auto noSetup = []() {};
+
+  for(const auto& operation : operations) {
+    Measurement result;
+    if(operation == "insert") {
+      result = measureSteps(config, keys.size(), [&]() { scratch.reset(new M); }, [&](std::size_t i) {
+        (*scratch)[keys[i]] = typename M::mapped_type();
+      });
+    } else if(operation == "hit" || operation == "miss") {
+      const auto& stream = operation == "hit" ? lookups : missingKeys;
+      result = measureSteps(config, stream.size(), noSetup, [&](std::size_t i) {
+        found += map.tryGet(stream[i]) != nullptr;
+      });
+    } else if(operation == "iterate") {
+      result = measure(config, keys.size(), noSetup, [&]() {
+        std::size_t sum = 0;
+        for(auto it = map.cbegin(); it != map.cend(); ++it)
+          sum += static_cast<std::size_t>(it->first); // touch every element
+        sink = sum;
+      });
+    } else if(operation == "remove") {
+      result = measureSteps(config, keys.size(), [&]() { scratch.reset(new M(map)); }, [&](std::size_t i) {
+        scratch->remove(lookups[i]);
+      });
+    } else if(operation == "copy") {
+      result = measure(config, keys.size(), [&]() { scratch.reset(); }, [&]() {
+        scratch.reset(new M(map));
+      });
+    } else {
+      throw std::invalid_argument("unknown operation: " + operation);
+    }
+    result.map = name;
+    result.operation = operation;
+    result.size = keys.size();
+    result.bytesPerEntry = bytesPerEntry;
+    result.memory = memory;
+    results.push_back(result);
+  }
+  sink = found;
+  (void)sink;
+}
+
+// replays operations against copies of a map holding prefillKeys
+template <typename M>
+void benchmarkWorkload(const std::string& name, const std::string& workload,
+                       const std::vector<std::uint64_t>& prefillKeys, const std::vector<Operation>& operations,
+                       const BenchmarkConfig& config, std::vector<Measurement>& results)
+{
+  const std::size_t bytesBefore = currentAllocations().liveBytes;
+  M map;
+  for(const auto& key : prefillKeys)
+    map[static_cast<typename M::key_type>(key)] = typename M::mapped_type();
+  const std::size_t bytes = currentAllocations().liveBytes - bytesBefore;
+
+  std::unique_ptr<M> scratch;
+  std::size_t hits = 0;
+  volatile std::size_t sink = 0;
+  Measurement result = measureSteps(config, operations.size(), [&]() { scratch.reset(new M(map)); },
+    [&](std::size_t i) {
+      hits += replayOne(*scratch, operations[i]);
+    });
+  sink = hits;
+  (void)sink;
+  result.map = name;
+  result.operation = workload;
+  result.size = map.getSize();
+  result.bytesPerEntry = result.size == 0 ? 0 : double(bytes) / result.size;
+  result.memory = reportedMemoryUsage(map);
+  results.push_back(result);
+}
+
+inline void printText(std::ostream& out, const std::vector<Measurement>& results)
+{
+  out << "map\tsize\toperation\tns/op\tstddev\tbest\tMops/s\tB/entry" << std::endl;
+  for(const auto& result : results)
+    out << result.map << "\t" << result.size << "\t" << result.operation << "\t"
+        << result.nsPerOperation << "\t" << result.stddev << "\t" << result.bestNsPerOperation << "\t"
+        << result.operationsPerSecond / 1e6 << "\t" << result.bytesPerEntry << std::endl;
+
+  if(results.empty() || results.front().counters.empty())
+    return;
+  out << std::endl << "hardware counters per operation (nan - not available)" << std::endl
+      << "map\tsize\toperation";
+  for(const auto& counter : results.front().counters)
+    out << "\t" << counter.first;
+  out << "\tIPC" << std::endl;
+  for(const auto& result : results) {
+    double cycles = std::nan(""), instructions = std::nan("");
+    out << result.map << "\t" << result.size << "\t" << result.operation;
+    for(const auto& counter : result.counters) {
+      out << "\t" << counter.second;
+      if(counter.first == "cycles")
+        cycles = counter.second;
+      else if(counter.first == "instructions")
+        instructions = counter.second;
+    }
+    out << "\t" << instructions / cycles << std::endl;
+  }
+}
+
+inline void printJson(std::ostream& out, const std::vector<Measurement>& results)
+{
+  out << "[" << std::endl;
+  for(std::size_t i = 0; i < results.size(); i++) {
+    const auto& result = results[i];
+    out << "  { \"map\": \"" << result.map << "\", \"size\": " << result.size
+        << ", \"operation\": \"" << result.operation << "\", \"repetitions\": " << result.repetitions
+        << ", \"ns_per_op\": " << result.nsPerOperation << ", \"stddev\": " << result.stddev
+        << ", \"best_ns_per_op\": " << result.bestNsPerOperation
+        << ", \"ops_per_second\": " << result.operationsPerSecond
+        << ", \"bytes_per_entry\": " << result.bytesPerEntry;
+    if(result.memory.allocations != 0)
+      out << ", \"memory\": { \"allocations\": " << result.memory.allocations
+          << ", \"requested_bytes\": " << result.memory.requestedBytes
+          << ", \"heap_bytes\": " << result.memory.heapBytes
+          << ", \"payload_bytes\": " << result.memory.payloadBytes << " }";
+    if(!result.counters.empty()) {
+      out << ", \"counters\": {";
+      for(std::size_t j = 0; j < result.counters.size(); j++) {
+        out << (j ? ", " : " ") << "\"" << result.counters[j].first << "\": ";
+        if(std::isnan(result.counters[j].second))
+          out << "null";
+        else
+          out << result.counters[j].second;
+      }
+      out << " }";
+    }
+    if(result.latency.count() != 0)
+      out << ", \"latency\": { \"samples\": " << result.latency.count()
+          << ", \"p50\": " << result.latency.percentile(0.5) << ", \"p90\": " << result.latency.percentile(0.9)
+          << ", \"p99\": " << result.latency.percentile(0.99) << ", \"p99_9\": " << result.latency.percentile(0.999)
+          << ", \"max\": " << result.latency.max() << " }";
+    out << " }"
+        << (i + 1 < results.size() ? "," : "") << std::endl;
+  }
+  out << "]" << std::endl;
+}
+
+/*
+ * Memory per entry of every map and size: heap bytes counted by operator new (when the counter is installed),
+ * reported by memoryUsage() of the map, the payload (key and value) and the allocations made per entry.
+ */
+inline void printMemory(std::ostream& out, const std::vector<Measurement>& results)
+{
+  const auto flags = out.flags();
+  out << std::fixed << std::setprecision(2);
+  out << std::endl << "memory per entry" << std::endl
+      << "map\tsize\tcounted B\treported B\tpayload B\toverhead\tallocations" << std::endl;
+  std::vector<std::pair<std::string, std::size_t>> printed;
+  for(const auto& result : results) {
+    const auto row = std::make_pair(result.map, result.size);
+    if(result.size == 0 || std::find(printed.begin(), printed.end(), row) != printed.end())
+      continue;
+    printed.push_back(row);
+    out << result.map << "\t" << result.size << "\t";
+    if(allocationCountingAvailable())
+      out << result.bytesPerEntry;
+    else
+      out << "-";
+    const MemoryUsage& memory = result.memory;
+    if(memory.allocations == 0) {
+      out << "\t-\t-\t-\t-" << std::endl;
+      continue;
+    }
+    out << "\t" << double(memory.heapBytes) / result.size << "\t" << double(memory.payloadBytes) / result.size
+        << "\t" << 100.0 * memory.overheadBytes() / memory.heapBytes << "%"
+        << "\t" << double(memory.allocations) / result.size << std::endl;
+  }
+  out.flags(flags);
+}
+
+// Percentiles of per-operation latencies, for the measurements that recorded them.
+inline void printLatency(std::ostream& out, const std::vector<Measurement>& results, std::size_t batch)
+{
+  out << std::endl << "latency (ns per operation, batches of " << batch << ")" << std::endl
+      << "map\tsize\toperation\tp50\tp90\tp99\tp99.9\tmax" << std::endl;
+  for(const auto& result : results) {
+    const LatencyHistogram& latency = result.latency;
+    if(latency.count() == 0)
+      continue;
+    out << result.map << "\t" << result.size << "\t" << result.operation << "\t" << latency.percentile(0.5)
+        << "\t" << latency.percentile(0.9) << "\t" << latency.percentile(0.99) << "\t"
+        << latency.percentile(0.999) << "\t" << latency.max() << std::endl;
+  }
+}
+
+// Whole latency histograms, a "# map size operation" header before each - for diffing between runs.
+inline void dumpLatency(std::ostream& out, const std::vector<Measurement>& results)
+{
+  for(const auto& result : results) {
+    if(result.latency.count() == 0)
+      continue;
+    out << "# " << result.map << " " << result.size << " " << result.operation << std::endl;
+    result.latency.dump(out);
+  }
+}
+
+/*
+ * Table of every map against baseline, for each size and operation:
+ * speedup = baseline ns/op / map ns/op (above 1 - faster than baseline).
+ */
+inline void printComparison(std::ostream& out, const std::vector<Measurement>& results, const std::string& baseline)
+{
+  std::vector<std::string> maps;
+  for(const auto& result : results)
+    if(std::find(maps.begin(), maps.end(), result.map) == maps.end())
+      maps.push_back(result.map);
+  const auto lookup = [&results](const std::string& map, std::size_t size, const std::string& operation) {
+    for(const auto& result : results)
+      if(result.map == map && result.size == size && result.operation == operation)
+        return &result;
+    return static_cast<const Measurement*>(nullptr);
+  };
+
+  const auto flags = out.flags();
+  out << std::fixed << std::setprecision(2);
+  out << std::endl << "speedup over " << baseline << std::endl << "size\toperation";
+  for(const auto& map : maps)
+    out << "\t" << map;
+  out << std::endl;
+  for(const auto& row : results) {
+    if(row.map != maps.front())
+      continue;
+    const Measurement* base = lookup(baseline, row.size, row.operation);
+    out << row.size << "\t" << row.operation;
+    for(const auto& map : maps) {
+      const Measurement* result = lookup(map, row.size, row.operation);
+      if(base == nullptr || result == nullptr)
+        out << "\t-";
+      else
+        out << "\t" << base->nsPerOperation / result->nsPerOperation << "x";
+    }
+    out << std::endl;
+  }
+  out.flags(flags);
+}
+
+/*
+ * Where every map stops beating baseline, for each operation: the largest measured size up to which
+ * it is faster at every size, and the first size at which it is slower ("-" when there is none).
+ * E.g. a flat map against a tree - fast while small, losing once inserts shift long arrays.
+ */
+inline void printCrossover(std::ostream& out, const std::vector<Measurement>& results, const std::string& baseline)
+{
+  const auto nsOf = [&results](const std::string& map, std::size_t size, const std::string& operation) {
+    for(const auto& result : results)
+      if(result.map == map && result.size == size && result.operation == operation)
+        return result.nsPerOperation;
+    return std::nan("");
+  };
+
+  out << std::endl << "crossover against " << baseline << std::endl
+      << "map\toperation\tfaster up to\tslower from" << std::endl;
+  std::vector<std::pair<std::string, std::string>> printed;
+  for(const auto& row : results) {
+    const auto key = std::make_pair(row.map, row.operation);
+    if(row.map == baseline || std::find(printed.begin(), printed.end(), key) != printed.end())
+      continue;
+    printed.push_back(key);
+    std::vector<std::size_t> sizes;
+    for(const auto& result : results)
+      if(result.map == row.map && result.operation == row.operation)
+        sizes.push_back(result.size);
+    std::sort(sizes.begin(), sizes.end());
+
+    std::string fasterUpTo = "-", slowerFrom = "-";
+    for(std::size_t size : sizes) {
+      const double base = nsOf(baseline, size, row.operation);
+      if(std::isnan(base))
+        continue;
+      if(nsOf(row.map, size, row.operation) > base) {
+        slowerFrom = std::to_string(size);
+        break;
+      }
+      fasterUpTo = std::to_string(size);
+    }
+    out << row.map << "\t" << row.operation << "\t" << fasterUpTo << "\t" << slowerFrom << std::endl;
+  }
+}
+
+}
+
+#endif /* AISDI_MAPS_BENCHMARK_H */
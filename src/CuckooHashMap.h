@@ -0,0 +1,688 @@
+#ifndef AISDI_MAPS_CUCKOOHASHMAP_H
+#define AISDI_MAPS_CUCKOOHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Hash.h"
+#include "InterleavedLookup.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+const std::size_t CACHE_LINE = 64;
+
+// bytes of a CuckooHashMap bucket: a tag per slot, then the slots
+constexpr std::size_t cuckooBucketBytes(std::size_t entrySize, std::size_t entryAlignment, std::size_t slots)
+{
+  return (slots + entryAlignment - 1) / entryAlignment * entryAlignment + slots * entrySize;
+}
+
+// slots of a CuckooHashMap bucket: as many entries as fit in a cache line after their tags, 2 to 4
+constexpr std::size_t cuckooSlots(std::size_t entrySize, std::size_t entryAlignment, std::size_t slots = 4)
+{
+  return slots == 2 || cuckooBucketBytes(entrySize, entryAlignment, slots) <= CACHE_LINE
+    ? slots : cuckooSlots(entrySize, entryAlignment, slots - 1);
+}
+
+/*
+ * Bucketized cuckoo hashing, for lookups with a worst case instead of an expected one: every key lives
+ * in one of the SLOTS slots of one of its two buckets (or in a small stash), so find() reads two buckets
+ * and the stash - never a chain. A bucket keeps a one-byte tag per slot, taken from the key's hash,
+ * and keys are compared only where the tag matches. A bucket holds as many slots as fit in a cache line
+ * next to their tags (see cuckooSlots()) and is aligned to the line, so with entries of up to 28 bytes
+ * a lookup touches at most two lines besides the stash. Buckets of larger entries span lines anyway
+ * and are not padded. The second bucket is computed from the first one and the tag (partial-key cuckoo
+ * hashing), so entries can be moved to their other bucket without hashing their keys again.
+ *
+ * When both buckets of a new key are full, a breadth-first search over at most MAX_SEARCHED_BUCKETS
+ * buckets looks for the shortest chain of entries to move to their other buckets, and the chain is moved
+ * starting from the free slot - every entry is written to its new slot before it leaves the old one,
+ * as readers working without locks would need. A key with no chain found goes to the stash; a full stash
+ * grows the table, whatever its load, so the stash never holds more than STASH_SIZE entries. The table
+ * also grows past MAX_LOAD_PERCENT of the slots taken.
+ *
+ * Iteration order is unspecified. Insertions move entries and invalidate iterators and references.
+ */
+template <typename KeyType, typename ValueType,
+          typename Hash = aisdi::Hash<KeyType>, typename KeyEqual = aisdi::EqualTo<KeyType>>
+class CuckooHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  static const size_type SLOTS = cuckooSlots(sizeof(value_type), alignof(value_type));
+  static const size_type MIN_NO_OF_BUCKETS = 4;
+  static const size_type STASH_SIZE = 4;
+  static const size_type MAX_SEARCHED_BUCKETS = 256;
+  static const size_type MAX_LOAD_PERCENT = 90;
+  static const size_type MIN_LOAD_PERCENT = 10; // a full stash below it is the hash's fault, see place()
+
+  CuckooHashMap() : buckets(MIN_NO_OF_BUCKETS), size(0), seed(randomSeed())
+  {}
+
+  CuckooHashMap(std::initializer_list<value_type> list) : CuckooHashMap()
+  {
+    for(auto element : list)
+      operator[](element.first) = element.second;
+  }
+
+  CuckooHashMap(const CuckooHashMap& other) : buckets(other.buckets.size()), size(other.size), seed(other.seed)
+  {
+    for(size_type bucket = 0; bucket < buckets.size(); bucket++)
+      for(size_type slot = 0; slot < SLOTS; slot++)
+        if(other.buckets[bucket].tags[slot] != EMPTY) {
+          new (buckets[bucket].slot(slot)) value_type(other.buckets[bucket].item(slot));
+          buckets[bucket].tags[slot] = other.buckets[bucket].tags[slot];
+        }
+    for(const auto& entry : other.stash)
+      stash.emplace_back(new value_type(*entry));
+  }
+
+  CuckooHashMap(CuckooHashMap&& other) : CuckooHashMap()
+  {
+    swap(*this, other);
+  }
+
+  CuckooHashMap& operator=(CuckooHashMap other)
+  {
+    swap(*this, other);
+    return *this;
+  }
+
+  friend void swap(CuckooHashMap& first, CuckooHashMap& second)
+  {
+    using std::swap;
+    swap(first.buckets, second.buckets);
+    swap(first.stash, second.stash);
+    swap(first.size, second.size);
+    swap(first.seed, second.seed);
+  }
+
+  ~CuckooHashMap()
+  {
+    destroyBuckets(buckets);
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    const std::uint64_t hash = hashOf(key);
+    const size_type position = locate(key, hash);
+    if(position != endPosition())
+      return itemAt(position).second;
+    if((size + 1) * 100 > buckets.size() * SLOTS * MAX_LOAD_PERCENT)
+      grow();
+    const size_type placed = place(hash, key, mapped_type{});
+    size++;
+    return itemAt(placed).second;
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    if(isEmpty())
+      throw std::out_of_range("empty map, cannot get value");
+    const mapped_type *value = tryGet(key);
+    if(value == nullptr)
+      throw std::out_of_range("element with given key does not exist");
+    return *value;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<mapped_type&>(static_cast<const CuckooHashMap*>(this)->valueOf(key));
+  }
+
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    const size_type position = locate(key, hashOf(key));
+    return position == endPosition() ? nullptr : &itemAt(position).second;
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const CuckooHashMap*>(this)->tryGet(key));
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(locate(key, hashOf(key)), *this);
+  }
+
+  iterator find(const key_type& key)
+  {
+    return static_cast<const CuckooHashMap*>(this)->find(key);
+  }
+
+  void remove(const key_type& key)
+  {
+    if(isEmpty())
+      throw std::out_of_range("cannot remove, empty list");
+    const size_type position = locate(key, hashOf(key));
+    if(position == endPosition())
+      throw std::out_of_range("cannot remove, element does not exist");
+    erase(position);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it == cend())
+      throw std::out_of_range("cannot remove end");
+    erase(it.position);
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  // the bucket array, the stash and its entries
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage;
+    usage.addBlocks(1, buckets.capacity() * sizeof(Bucket));
+    if(stash.capacity() != 0)
+      usage.addBlocks(1, stash.capacity() * sizeof(std::unique_ptr<value_type>));
+    usage.addBlocks(stash.size(), sizeof(value_type));
+    usage.payloadBytes = size * sizeof(value_type);
+    return usage;
+  }
+
+  // entries that found no place in their buckets - 0 unless the table is very full or the hash is poor
+  size_type stashSize() const
+  {
+    return stash.size();
+  }
+
+  // bytes of one bucket - a cache line, unless the entries are too large for two of them to fit
+  static constexpr size_type bucketBytes()
+  {
+    return sizeof(Bucket);
+  }
+
+  bool operator==(const CuckooHashMap& other) const
+  {
+    if(size != other.size)
+      return false;
+    for(const auto& element : other) {
+      const mapped_type *value = tryGet(element.first);
+      if(value == nullptr || !(*value == element.second))
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const CuckooHashMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return cbegin();
+  }
+
+  iterator end()
+  {
+    return cend();
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(nextFrom(0), *this);
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(endPosition(), *this);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  static const std::uint8_t EMPTY = 0;
+  static const size_type BUCKET_ALIGNMENT =
+    cuckooBucketBytes(sizeof(value_type), alignof(value_type), SLOTS) <= CACHE_LINE ? CACHE_LINE : alignof(value_type);
+
+  struct alignas(BUCKET_ALIGNMENT) Bucket
+  {
+    std::uint8_t tags[SLOTS] = {}; // EMPTY for a free slot
+    alignas(value_type) unsigned char storage[SLOTS * sizeof(value_type)];
+
+    void* slot(size_type index)
+    {
+      return storage + index * sizeof(value_type);
+    }
+
+    value_type& item(size_type index)
+    {
+      return *std::launder(reinterpret_cast<value_type*>(storage) + index);
+    }
+
+    const value_type& item(size_type index) const
+    {
+      return *std::launder(reinterpret_cast<const value_type*>(storage) + index);
+    }
+
+    // SLOTS when the bucket is full
+    size_type freeSlot() const
+    {
+      size_type index = 0;
+      while(index < SLOTS && tags[index] != EMPTY)
+        index++;
+      return index;
+    }
+  };
+
+  static_assert(BUCKET_ALIGNMENT != CACHE_LINE || sizeof(Bucket) == CACHE_LINE,
+                "a bucket of small entries takes one cache line");
+
+  // a bucket reached by the search for a free slot, and the slot of its parent whose entry would move to it
+  struct SearchStep
+  {
+    size_type bucket;
+    size_type parent; // index of the parent step, NO_PARENT for the key's own buckets
+    size_type parentSlot;
+  };
+  static const size_type NO_PARENT = static_cast<size_type>(-1);
+
+  std::vector<Bucket> buckets; // power of two of them
+  std::vector<std::unique_ptr<value_type>> stash;
+  size_type size;
+  std::uint64_t seed; // random per map, so colliding keys cannot be precomputed by a client
+
+  CuckooHashMap(size_type noOfBuckets, std::uint64_t seed) : buckets(noOfBuckets), size(0), seed(seed)
+  {}
+
+  std::uint64_t hashOf(const key_type& key) const
+  {
+    return seededHash<hasher>(key, seed);
+  }
+
+  static std::uint8_t tagOf(std::uint64_t hash)
+  {
+    const std::uint8_t tag = static_cast<std::uint8_t>(hash >> 56);
+    return tag == EMPTY ? 1 : tag;
+  }
+
+  size_type primaryBucket(std::uint64_t hash) const
+  {
+    return static_cast<size_type>(hash) & (buckets.size() - 1);
+  }
+
+  // the other bucket of an entry - the same formula leads from either bucket to the other one
+  size_type alternateBucket(size_type bucket, std::uint8_t tag) const
+  {
+    return (bucket ^ static_cast<size_type>(mixBits(tag))) & (buckets.size() - 1);
+  }
+
+  // positions: bucket * SLOTS + slot, then the stash, endPosition() for none
+  size_type endPosition() const
+  {
+    return buckets.size() * SLOTS + stash.size();
+  }
+
+  value_type& itemAt(size_type position)
+  {
+    if(position >= buckets.size() * SLOTS)
+      return *stash[position - buckets.size() * SLOTS];
+    return buckets[position / SLOTS].item(position % SLOTS);
+  }
+
+  const value_type& itemAt(size_type position) const
+  {
+    return const_cast<CuckooHashMap*>(this)->itemAt(position);
+  }
+
+  bool isOccupied(size_type position) const
+  {
+    return position >= buckets.size() * SLOTS || buckets[position / SLOTS].tags[position % SLOTS] != EMPTY;
+  }
+
+  size_type locate(const key_type& key, std::uint64_t hash) const
+  {
+    const std::uint8_t tag = tagOf(hash);
+    const size_type first = primaryBucket(hash);
+    const size_type second = alternateBucket(first, tag);
+    prefetch(&buckets[second]); // both cache misses in flight at once
+    for(const size_type bucket : { first, second })
+      for(size_type slot = 0; slot < SLOTS; slot++)
+        if(buckets[bucket].tags[slot] == tag && key_equal{}(buckets[bucket].item(slot).first, key))
+          return bucket * SLOTS + slot;
+    for(size_type index = 0; index < stash.size(); index++)
+      if(key_equal{}(stash[index]->first, key))
+        return buckets.size() * SLOTS + index;
+    return endPosition();
+  }
+
+  // constructs the entry in one of its buckets, making room if needed, returns its position
+  template <typename... Args>
+  size_type place(std::uint64_t hash, Args&&... args)
+  {
+    const std::uint8_t tag = tagOf(hash);
+    const size_type first = primaryBucket(hash);
+    const size_type second = alternateBucket(first, tag);
+    size_type bucket = first, slot = buckets[first].freeSlot();
+    if(slot == SLOTS) {
+      bucket = second;
+      slot = buckets[second].freeSlot();
+    }
+    if(slot == SLOTS && makeRoom(first, second, bucket, slot) == false) {
+      if(stash.size() < STASH_SIZE) {
+        stash.emplace_back(new value_type(std::forward<Args>(args)...));
+        return endPosition() - 1;
+      }
+      // a hash sending too many keys to the same buckets fills the stash while the table is nearly empty,
+      // no size would separate them
+      if(size * 100 < buckets.size() * SLOTS * MIN_LOAD_PERCENT)
+        throw std::length_error("cannot add, too many keys share their buckets");
+      grow();
+      return place(hash, std::forward<Args>(args)...);
+    }
+    new (buckets[bucket].slot(slot)) value_type(std::forward<Args>(args)...);
+    buckets[bucket].tags[slot] = tag;
+    return bucket * SLOTS + slot;
+  }
+
+  // breadth-first search for entries to move out of the way, frees slot in bucket (first or second)
+  bool makeRoom(size_type first, size_type second, size_type& bucket, size_type& slot)
+  {
+    std::vector<SearchStep> steps = { { first, NO_PARENT, 0 }, { second, NO_PARENT, 0 } };
+    for(size_type step = 0; step < steps.size() && steps.size() < MAX_SEARCHED_BUCKETS; step++) {
+      const size_type current = steps[step].bucket;
+      for(size_type candidate = 0; candidate < SLOTS; candidate++) {
+        const size_type target = alternateBucket(current, buckets[current].tags[candidate]);
+        const size_type targetSlot = buckets[target].freeSlot();
+        if(targetSlot == SLOTS) {
+          if(!isOnPath(steps, step, target))
+            steps.push_back({ target, step, candidate });
+          continue;
+        }
+        // from the free slot back to the key's bucket, each entry written to its new slot before leaving the old
+        moveEntry(current, candidate, target, targetSlot);
+        size_type freedBucket = current, freedSlot = candidate;
+        for(size_type back = step; steps[back].parent != NO_PARENT; back = steps[back].parent) {
+          const SearchStep& moved = steps[back];
+          moveEntry(steps[moved.parent].bucket, moved.parentSlot, freedBucket, freedSlot);
+          freedBucket = steps[moved.parent].bucket;
+          freedSlot = moved.parentSlot;
+        }
+        bucket = freedBucket;
+        slot = freedSlot;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // a bucket twice on one path would have its entries moved twice
+  static bool isOnPath(const std::vector<SearchStep>& steps, size_type step, size_type bucket)
+  {
+    for( ; step != NO_PARENT; step = steps[step].parent)
+      if(steps[step].bucket == bucket)
+        return true;
+    return false;
+  }
+
+  void moveEntry(size_type fromBucket, size_type fromSlot, size_type toBucket, size_type toSlot)
+  {
+    value_type& entry = buckets[fromBucket].item(fromSlot);
+    new (buckets[toBucket].slot(toSlot)) value_type(std::move(entry));
+    buckets[toBucket].tags[toSlot] = buckets[fromBucket].tags[fromSlot];
+    entry.~value_type();
+    buckets[fromBucket].tags[fromSlot] = EMPTY;
+  }
+
+  void erase(size_type position)
+  {
+    size--;
+    if(position >= buckets.size() * SLOTS) {
+      const size_type index = position - buckets.size() * SLOTS;
+      std::swap(stash[index], stash.back());
+      stash.pop_back();
+      return;
+    }
+    Bucket& bucket = buckets[position / SLOTS];
+    bucket.item(position % SLOTS).~value_type();
+    bucket.tags[position % SLOTS] = EMPTY;
+    if(!stash.empty())
+      unstash();
+  }
+
+  // moves stashed entries whose buckets have room now back to the table
+  void unstash()
+  {
+    for(size_type index = 0; index < stash.size(); ) {
+      const std::uint64_t hash = hashOf(stash[index]->first);
+      const size_type first = primaryBucket(hash);
+      const size_type second = alternateBucket(first, tagOf(hash));
+      const size_type bucket = buckets[first].freeSlot() != SLOTS ? first : second;
+      const size_type slot = buckets[bucket].freeSlot();
+      if(slot == SLOTS) {
+        index++;
+        continue;
+      }
+      new (buckets[bucket].slot(slot)) value_type(std::move(*stash[index]));
+      buckets[bucket].tags[slot] = tagOf(hash);
+      std::swap(stash[index], stash.back());
+      stash.pop_back();
+    }
+  }
+
+  /*
+   * Rehashes into a table twice as large, built aside and swapped in once every entry is placed.
+   * When placing throws (a full stash in a nearly empty table, an allocation) the map is left as it was:
+   * the keys are const, so moving an entry copies its key - only the values of the entries placed so far
+   * are moved back.
+   */
+  void grow()
+  {
+    CuckooHashMap rehashed(2 * buckets.size(), seed);
+    rehashed.size = size; // the load place() checks before giving up is that of the whole map
+    size_type position = nextFrom(0);
+    try {
+      for( ; position != endPosition(); position = nextFrom(position + 1))
+        rehashed.place(hashOf(itemAt(position).first), std::move(itemAt(position)));
+    } catch(...) {
+      for(size_type placed = nextFrom(0); placed != position; placed = nextFrom(placed + 1)) {
+        value_type& entry = itemAt(placed);
+        entry.second = std::move(rehashed.itemAt(rehashed.locate(entry.first, hashOf(entry.first))).second);
+      }
+      throw;
+    }
+    swap(*this, rehashed);
+  }
+
+  static void destroyBuckets(std::vector<Bucket>& table)
+  {
+    for(auto& bucket : table)
+      for(size_type slot = 0; slot < SLOTS; slot++)
+        if(bucket.tags[slot] != EMPTY) {
+          bucket.item(slot).~value_type();
+          bucket.tags[slot] = EMPTY;
+        }
+  }
+
+  // first occupied position >= position, endPosition() when there is none
+  size_type nextFrom(size_type position) const
+  {
+    while(position < endPosition() && !isOccupied(position))
+      position++;
+    return position;
+  }
+
+  // last occupied position < position, endPosition() when there is none
+  size_type previousBefore(size_type position) const
+  {
+    while(position > 0)
+      if(isOccupied(--position))
+        return position;
+    return endPosition();
+  }
+};
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+class CuckooHashMap<KeyType, ValueType, Hash, KeyEqual>::ConstIterator
+{
+public:
+  using reference = typename CuckooHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename CuckooHashMap::value_type;
+  using pointer = const typename CuckooHashMap::value_type*;
+
+  friend class CuckooHashMap;
+
+  explicit ConstIterator() : position(0), map(nullptr)
+  {}
+
+  explicit ConstIterator(size_type position, const CuckooHashMap& map) : position(position), map(&map)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(position >= map->endPosition())
+      throw std::out_of_range("cannot increment end");
+    position = map->nextFrom(position + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator old(*this);
+    operator++();
+    return old;
+  }
+
+  ConstIterator& operator--()
+  {
+    const size_type previous = map->previousBefore(position);
+    if(previous == map->endPosition())
+      throw std::out_of_range(map->isEmpty() ? "cannot decrement begin, empty map" : "cannot decrement begin");
+    position = previous;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator old(*this);
+    operator--();
+    return old;
+  }
+
+  reference operator*() const
+  {
+    if(position >= map->endPosition())
+      throw std::out_of_range("cannot dereference end");
+    return map->itemAt(position);
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return position == other.position && map == other.map;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  size_type position; // see endPosition()
+  const CuckooHashMap *map;
+};
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+class CuckooHashMap<KeyType, ValueType, Hash, KeyEqual>::Iterator
+  : public CuckooHashMap<KeyType, ValueType, Hash, KeyEqual>::ConstIterator
+{
+public:
+  using reference = typename CuckooHashMap::reference;
+  using pointer = typename CuckooHashMap::value_type*;
+
+  explicit Iterator()
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_CUCKOOHASHMAP_H */
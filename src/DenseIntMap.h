@@ -0,0 +1,439 @@
+#ifndef AISDI_MAPS_DENSEINTMAP_H
+#define AISDI_MAPS_DENSEINTMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ArrowProxy.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+/*
+ * Direct addressing for integer keys known to lie in [0, MaxKey) - ports, small ids, enum-like codes:
+ * the value of key k is values[k] and bit k of a bitset tells whether it is there. A lookup is a range check,
+ * one bit test and one load, no hashing and no chains. Iteration goes in ascending key order
+ * and skips 64 absent keys at a time by scanning the bitset with count-trailing-zeros.
+ *
+ * Both arrays are allocated by the constructor for the whole range - MaxKey values whatever the size,
+ * so it only pays off while a good part of the range is used. Keys out of the range are never present:
+ * operator[] throws std::out_of_range for them, lookups report a miss.
+ *
+ * Keys are not stored, so iterators dereference to a pair of the key and a reference to the value
+ * (it->first, it->second work as usual). Values of removed keys are reset to ValueType{}.
+ */
+template <typename KeyType, typename ValueType, std::size_t MaxKey>
+class DenseIntMap
+{
+  static_assert(std::is_integral<KeyType>::value, "DenseIntMap needs integer keys");
+  static_assert(MaxKey > 0, "DenseIntMap needs a nonempty key range");
+  static_assert(MaxKey - 1 <= std::numeric_limits<std::make_unsigned_t<KeyType>>::max() &&
+                (std::is_unsigned<KeyType>::value ||
+                 MaxKey - 1 <= static_cast<std::size_t>(std::numeric_limits<KeyType>::max())),
+                "MaxKey does not fit in KeyType");
+
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = std::pair<const key_type, mapped_type&>;
+  using const_reference = std::pair<const key_type, const mapped_type&>;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  DenseIntMap() : values(MaxKey), occupied((MaxKey + 63) / 64, 0), size(0)
+  {}
+
+  DenseIntMap(std::initializer_list<value_type> list) : DenseIntMap()
+  {
+    for(auto element : list)
+      operator[](element.first) = element.second;
+  }
+
+  DenseIntMap(const DenseIntMap& other) = default;
+
+  DenseIntMap(DenseIntMap&& other) : DenseIntMap()
+  {
+    swap(*this, other);
+  }
+
+  DenseIntMap& operator=(DenseIntMap other)
+  {
+    swap(*this, other);
+    return *this;
+  }
+
+  friend void swap(DenseIntMap& first, DenseIntMap& second)
+  {
+    using std::swap;
+    swap(first.values, second.values);
+    swap(first.occupied, second.occupied);
+    swap(first.size, second.size);
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    if(!inRange(key))
+      throw std::out_of_range("key out of range of the map");
+    const size_type index = static_cast<size_type>(key);
+    if(!isOccupied(index)) {
+      occupied[index / 64] |= bit(index);
+      size++;
+    }
+    return values[index];
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    if(isEmpty())
+      throw std::out_of_range("map is empty");
+    const mapped_type* value = tryGet(key);
+    if(value == nullptr)
+      throw std::out_of_range("key does not exist");
+    return *value;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<mapped_type&>(static_cast<const DenseIntMap*>(this)->valueOf(key));
+  }
+
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    return contains(key) ? &values[static_cast<size_type>(key)] : nullptr;
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const DenseIntMap*>(this)->tryGet(key));
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(contains(key) ? static_cast<size_type>(key) : MaxKey, *this);
+  }
+
+  iterator find(const key_type& key)
+  {
+    return static_cast<const DenseIntMap*>(this)->find(key);
+  }
+
+  void remove(const key_type& key)
+  {
+    if(isEmpty())
+      throw std::out_of_range("cannot remove, empty list");
+    if(!contains(key))
+      throw std::out_of_range("cannot remove, element does not exist");
+    erase(static_cast<size_type>(key));
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it == end())
+      throw std::out_of_range("cannot erase end");
+    erase(it.position);
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  // the value array and the bitset, both for the whole key range
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage;
+    if(values.capacity() != 0)
+      usage.addBlocks(1, values.capacity() * sizeof(mapped_type));
+    if(occupied.capacity() != 0)
+      usage.addBlocks(1, occupied.capacity() * sizeof(std::uint64_t));
+    usage.payloadBytes = size * sizeof(value_type);
+    return usage;
+  }
+
+  bool operator==(const DenseIntMap& other) const
+  {
+    if(size != other.size || occupied != other.occupied)
+      return false;
+    for(auto it = cbegin(); it != cend(); ++it)
+      if(!(it->second == other.values[it.position]))
+        return false;
+    return true;
+  }
+
+  bool operator!=(const DenseIntMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return cbegin();
+  }
+
+  iterator end()
+  {
+    return cend();
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(firstFrom(0), *this);
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(MaxKey, *this);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  std::vector<mapped_type> values;
+  std::vector<std::uint64_t> occupied; // bit k of word k / 64 for key k
+  size_type size;
+
+  static std::uint64_t bit(size_type index)
+  {
+    return std::uint64_t(1) << (index % 64);
+  }
+
+  // negative keys turn into huge unsigned ones, so a single comparison checks both ends
+  static bool inRange(const key_type& key)
+  {
+    return static_cast<std::make_unsigned_t<key_type>>(key) < MaxKey;
+  }
+
+  bool isOccupied(size_type index) const
+  {
+    return (occupied[index / 64] & bit(index)) != 0;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return inRange(key) && isOccupied(static_cast<size_type>(key));
+  }
+
+  void erase(size_type index)
+  {
+    occupied[index / 64] &= ~bit(index);
+    values[index] = mapped_type{};
+    size--;
+  }
+
+  static int lowestBit(std::uint64_t word)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int lowest = 0;
+    for( ; (word & 1) == 0; word >>= 1)
+      lowest++;
+    return lowest;
+#endif
+  }
+
+  static int highestBit(std::uint64_t word)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(word);
+#else
+    int highest = 0;
+    while(word >>= 1)
+      highest++;
+    return highest;
+#endif
+  }
+
+  // first present key >= index, MaxKey when there is none
+  size_type firstFrom(size_type index) const
+  {
+    if(index >= MaxKey)
+      return MaxKey;
+    size_type word = index / 64;
+    std::uint64_t bits = occupied[word] & (~std::uint64_t(0) << (index % 64));
+    while(bits == 0) {
+      if(++word == occupied.size())
+        return MaxKey;
+      bits = occupied[word];
+    }
+    return word * 64 + lowestBit(bits);
+  }
+
+  // last present key < index, MaxKey when there is none
+  size_type lastBefore(size_type index) const
+  {
+    if(index == 0)
+      return MaxKey;
+    index--;
+    size_type word = index / 64;
+    std::uint64_t bits = occupied[word] & (~std::uint64_t(0) >> (63 - index % 64));
+    while(bits == 0) {
+      if(word-- == 0)
+        return MaxKey;
+      bits = occupied[word];
+    }
+    return word * 64 + highestBit(bits);
+  }
+};
+
+template <typename KeyType, typename ValueType, std::size_t MaxKey>
+class DenseIntMap<KeyType, ValueType, MaxKey>::ConstIterator
+{
+public:
+  using reference = typename DenseIntMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename DenseIntMap::value_type;
+  using difference_type = std::ptrdiff_t;
+
+  using pointer = ArrowProxy<reference>;
+
+  friend class DenseIntMap;
+
+  explicit ConstIterator() : position(MaxKey), map(nullptr)
+  {}
+
+  explicit ConstIterator(size_type position, const DenseIntMap& map) : position(position), map(&map)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(position == MaxKey)
+      throw std::out_of_range("cannot increment end");
+    position = map->firstFrom(position + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator old(*this);
+    operator++();
+    return old;
+  }
+
+  ConstIterator& operator--()
+  {
+    const size_type previous = map->lastBefore(position);
+    if(previous == MaxKey)
+      throw std::out_of_range(map->isEmpty() ? "cannot decrement begin, empty map" : "cannot decrement begin");
+    position = previous;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator old(*this);
+    operator--();
+    return old;
+  }
+
+  reference operator*() const
+  {
+    if(position == MaxKey)
+      throw std::out_of_range("cannot dereference end");
+    return reference(static_cast<key_type>(position), map->values[position]);
+  }
+
+  pointer operator->() const
+  {
+    return pointer(operator*());
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return position == other.position && map == other.map;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+
+protected:
+  size_type position; // the key, MaxKey for end
+  const DenseIntMap *map;
+};
+
+template <typename KeyType, typename ValueType, std::size_t MaxKey>
+class DenseIntMap<KeyType, ValueType, MaxKey>::Iterator : public DenseIntMap<KeyType, ValueType, MaxKey>::ConstIterator
+{
+public:
+  using reference = typename DenseIntMap::reference;
+  using pointer = ArrowProxy<reference>;
+
+  explicit Iterator()
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return pointer(operator*());
+  }
+
+  reference operator*() const
+  {
+    const auto item = ConstIterator::operator*();
+    // ugly cast, yet reduces code duplication.
+    return reference(item.first, const_cast<mapped_type&>(item.second));
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_DENSEINTMAP_H */
@@ -0,0 +1,680 @@
+#ifndef AISDI_MAPS_FLATHASHMAP_H
+#define AISDI_MAPS_FLATHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AISDI_MAPS_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "ArrayView.h"
+#include "Hash.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+/*
+ * Control bytes of FlatHashMap, one per slot: the low 7 bits of the key's hash for a full slot,
+ * or the negative marker below.
+ */
+namespace control
+{
+const std::int8_t EMPTY = -128;  // 0b10000000
+}
+
+// bit i set for byte i of a group; a set of slots of one group
+using GroupMask = std::uint32_t;
+
+inline int lowestBit(GroupMask mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(mask);
+#else
+  int lowest = 0;
+  for( ; (mask & 1) == 0; mask >>= 1)
+    lowest++;
+  return lowest;
+#endif
+}
+
+/*
+ * Group kernels compare the 16 control bytes starting at a slot with a fingerprint at once.
+ * ScalarGroup works on two 64-bit words (SWAR) and builds everywhere; SseGroup needs SSE2,
+ * which every x86-64 CPU has, so it is picked when the compiler targets it - there is nothing
+ * to dispatch at run time. Wider AVX2 groups do not help: a lookup usually ends in its first group.
+ */
+class ScalarGroup
+{
+public:
+  static const std::size_t WIDTH = 16;
+
+  explicit ScalarGroup(const std::int8_t* position)
+  {
+    std::memcpy(words, position, sizeof(words));
+  }
+
+  GroupMask match(std::int8_t fingerprint) const
+  {
+    const std::uint64_t pattern = LSBS * static_cast<std::uint8_t>(fingerprint);
+    return bitsOf(zeroBytes(words[0] ^ pattern)) | bitsOf(zeroBytes(words[1] ^ pattern)) << 8;
+  }
+
+  // EMPTY is the only control byte with the high bit set
+  GroupMask matchEmpty() const
+  {
+    return bitsOf(words[0] & MSBS) | bitsOf(words[1] & MSBS) << 8;
+  }
+
+private:
+  static const std::uint64_t LSBS = 0x0101010101010101ull;
+  static const std::uint64_t MSBS = 0x8080808080808080ull;
+
+  std::uint64_t words[2]; // bytes in memory order on a little-endian machine
+
+  // the high bit of every zero byte, exactly - no false positives from borrows
+  static std::uint64_t zeroBytes(std::uint64_t word)
+  {
+    return ~(((word & ~MSBS) + ~MSBS) | word | ~MSBS);
+  }
+
+  // gathers the high bits of the eight bytes into the low eight bits
+  static GroupMask bitsOf(std::uint64_t highBits)
+  {
+    return static_cast<GroupMask>(((highBits >> 7) * 0x0102040810204080ull) >> 56);
+  }
+};
+
+#ifdef AISDI_MAPS_HAVE_SSE2
+class SseGroup
+{
+public:
+  static const std::size_t WIDTH = 16;
+
+  explicit SseGroup(const std::int8_t* position)
+    : bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(position)))
+  {}
+
+  GroupMask match(std::int8_t fingerprint) const
+  {
+    return static_cast<GroupMask>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(fingerprint), bytes)));
+  }
+
+  // EMPTY is the only control byte with the high bit set
+  GroupMask matchEmpty() const
+  {
+    return static_cast<GroupMask>(_mm_movemask_epi8(bytes));
+  }
+
+private:
+  __m128i bytes;
+};
+
+using DefaultGroup = SseGroup;
+#else
+using DefaultGroup = ScalarGroup;
+#endif
+
+/*
+ * Open addressing with control bytes, as in Abseil's SwissTable: entries are stored in one array
+ * of slots and a separate byte array keeps a 7-bit fingerprint of every full slot. A lookup
+ * compares the 16 control bytes starting at the key's home slot with the fingerprint (see Group),
+ * compares keys only in the slots that match - almost always just the right one - and stops
+ * at the first group with an empty slot. Lookups read the control bytes and usually one slot,
+ * instead of walking a chain of nodes spread over the heap as HashMap does.
+ *
+ * Probing is linear, with Robin Hood ordering: the entries of a run of full slots are kept in the order
+ * of their home slots, so an insertion goes before the first entry whose home is after its own,
+ * and a removal shifts the rest of the run one slot back until an entry already at home or an empty
+ * slot (backward-shift deletion). No entry is ever separated from its home by an empty slot, so
+ * removals need no tombstones: under any mix of insertions and removals probe lengths depend only on
+ * the load, never on the history. The price is moving entries on both - and hashing the keys
+ * of the moved run again, as homes are not stored. The table doubles past MAX_LOAD_PER_MILLE.
+ *
+ * Insertions and removals move entries, invalidating iterators and references.
+ */
+template <typename KeyType, typename ValueType,
+          typename Hash = aisdi::Hash<KeyType>, typename KeyEqual = aisdi::EqualTo<KeyType>,
+          typename Group = DefaultGroup>
+class FlatHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  static const size_type MIN_CAPACITY = Group::WIDTH;
+  static const size_type MAX_LOAD_PER_MILLE = 875;
+  static const size_type CHUNK_SIZE = 64; // entries per batch of forEachChunk()
+
+  FlatHashMap() : FlatHashMap(MIN_CAPACITY, randomSeed())
+  {}
+
+  FlatHashMap(std::initializer_list<value_type> list) : FlatHashMap()
+  {
+    for(auto element : list)
+      operator[](element.first) = element.second;
+  }
+
+  FlatHashMap(const FlatHashMap& other)
+    : controls(other.controls), slots(other.slots.size()), size(other.size), seed(other.seed)
+  {
+    for(size_type slot = 0; slot < slots.size(); slot++)
+      if(isFull(slot))
+        new (slots[slot].bytes) value_type(other.item(slot));
+  }
+
+  FlatHashMap(FlatHashMap&& other) : FlatHashMap()
+  {
+    swap(*this, other);
+  }
+
+  FlatHashMap& operator=(FlatHashMap other)
+  {
+    swap(*this, other);
+    return *this;
+  }
+
+  friend void swap(FlatHashMap& first, FlatHashMap& second)
+  {
+    using std::swap;
+    swap(first.controls, second.controls);
+    swap(first.slots, second.slots);
+    swap(first.size, second.size);
+    swap(first.seed, second.seed);
+  }
+
+  ~FlatHashMap()
+  {
+    destroyItems();
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    const std::uint64_t hash = hashOf(key);
+    const size_type position = locate(key, hash);
+    if(position != slots.size())
+      return item(position).second;
+    if((size + 1) * 1000 > slots.size() * MAX_LOAD_PER_MILLE)
+      rehash();
+    size++;
+    return emplace(hash, key, mapped_type{}).second;
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    if(isEmpty())
+      throw std::out_of_range("empty map, cannot get value");
+    const mapped_type *value = tryGet(key);
+    if(value == nullptr)
+      throw std::out_of_range("element with given key does not exist");
+    return *value;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<mapped_type&>(static_cast<const FlatHashMap*>(this)->valueOf(key));
+  }
+
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    const size_type position = locate(key, hashOf(key));
+    return position == slots.size() ? nullptr : &item(position).second;
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const FlatHashMap*>(this)->tryGet(key));
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(locate(key, hashOf(key)), *this);
+  }
+
+  iterator find(const key_type& key)
+  {
+    return static_cast<const FlatHashMap*>(this)->find(key);
+  }
+
+  void remove(const key_type& key)
+  {
+    if(isEmpty())
+      throw std::out_of_range("cannot remove, empty list");
+    const size_type position = locate(key, hashOf(key));
+    if(position == slots.size())
+      throw std::out_of_range("cannot remove, element does not exist");
+    erase(position);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it == cend())
+      throw std::out_of_range("cannot remove end");
+    erase(it.position);
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  size_type capacity() const
+  {
+    return slots.size();
+  }
+
+  // full slots per slot - lookups slow down as it approaches MAX_LOAD_PER_MILLE
+  double loadFactor() const
+  {
+    return static_cast<double>(size) / slots.size();
+  }
+
+  // slots read by a successful lookup on average - the distance from the home slot plus one
+  double averageProbeLength() const
+  {
+    size_type total = 0;
+    for(size_type slot = 0; slot < slots.size(); slot++)
+      if(isFull(slot))
+        total += distanceOf(slot) + 1;
+    return size == 0 ? 0.0 : static_cast<double>(total) / size;
+  }
+
+  /*
+   * Hands all entries to callback(ArrayView<const value_type* const>) in batches of up to CHUNK_SIZE,
+   * in iteration order - the full slots of a whole group are found with one matchEmpty(), so the
+   * empty ones cost no per-slot branch as in ConstIterator.
+   */
+  template <typename Callback>
+  void forEachChunk(Callback callback) const
+  {
+    const value_type *chunk[CHUNK_SIZE];
+    size_type count = 0;
+    const GroupMask allSlots = static_cast<GroupMask>((1ull << Group::WIDTH) - 1);
+    for(size_type first = 0; first < slots.size(); first += Group::WIDTH) {
+      for(GroupMask full = ~Group(controls.data() + first).matchEmpty() & allSlots; full != 0; full &= full - 1) {
+        chunk[count++] = &item(first + lowestBit(full));
+        if(count == CHUNK_SIZE) {
+          callback(ArrayView<const value_type* const>(chunk, count));
+          count = 0;
+        }
+      }
+    }
+    if(count != 0)
+      callback(ArrayView<const value_type* const>(chunk, count));
+  }
+
+  // the slots and the control bytes
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage;
+    usage.addBlocks(1, slots.capacity() * sizeof(Slot));
+    usage.addBlocks(1, controls.capacity());
+    usage.payloadBytes = size * sizeof(value_type);
+    return usage;
+  }
+
+  bool operator==(const FlatHashMap& other) const
+  {
+    if(size != other.size)
+      return false;
+    for(const auto& element : other) {
+      const mapped_type *value = tryGet(element.first);
+      if(value == nullptr || !(*value == element.second))
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const FlatHashMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return cbegin();
+  }
+
+  iterator end()
+  {
+    return cend();
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(nextFrom(0), *this);
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(slots.size(), *this);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  struct Slot
+  {
+    alignas(value_type) unsigned char bytes[sizeof(value_type)];
+  };
+
+  // one per slot, then a copy of the first Group::WIDTH - 1 so that a group can start at any slot
+  std::vector<std::int8_t> controls;
+  std::vector<Slot> slots; // a power of two of them, Group::WIDTH at least
+  size_type size;
+  std::uint64_t seed; // random per map, so colliding keys cannot be precomputed by a client
+
+  FlatHashMap(size_type capacity, std::uint64_t seed)
+    : controls(capacity + Group::WIDTH - 1, control::EMPTY), slots(capacity), size(0), seed(seed)
+  {}
+
+  std::uint64_t hashOf(const key_type& key) const
+  {
+    return seededHash<hasher>(key, seed);
+  }
+
+  static std::int8_t fingerprintOf(std::uint64_t hash)
+  {
+    return static_cast<std::int8_t>(hash & 0x7f);
+  }
+
+  size_type homeOf(std::uint64_t hash) const
+  {
+    return static_cast<size_type>(hash >> 7) & (slots.size() - 1);
+  }
+
+  bool isFull(size_type slot) const
+  {
+    return controls[slot] >= 0;
+  }
+
+  // how far the entry in a full slot is from its home slot
+  size_type distanceOf(size_type slot) const
+  {
+    return (slot - homeOf(hashOf(item(slot).first))) & (slots.size() - 1);
+  }
+
+  value_type& item(size_type slot)
+  {
+    return *std::launder(reinterpret_cast<value_type*>(slots[slot].bytes));
+  }
+
+  const value_type& item(size_type slot) const
+  {
+    return *std::launder(reinterpret_cast<const value_type*>(slots[slot].bytes));
+  }
+
+  void setControl(size_type slot, std::int8_t value)
+  {
+    controls[slot] = value;
+    if(slot < Group::WIDTH - 1)
+      controls[slots.size() + slot] = value;
+  }
+
+  // the slot of key, slots.size() when it is missing
+  size_type locate(const key_type& key, std::uint64_t hash) const
+  {
+    const size_type mask = slots.size() - 1;
+    const std::int8_t fingerprint = fingerprintOf(hash);
+    for(size_type position = homeOf(hash); ; position = (position + Group::WIDTH) & mask) {
+      const Group group(controls.data() + position);
+      for(GroupMask candidates = group.match(fingerprint); candidates != 0; candidates &= candidates - 1) {
+        const size_type slot = (position + lowestBit(candidates)) & mask;
+        if(key_equal{}(item(slot).first, key))
+          return slot;
+      }
+      if(group.matchEmpty() != 0)
+        return slots.size();
+    }
+  }
+
+  // constructs the entry before the first one of its run with a later home, moving the rest of the run on;
+  // the key must not be in the map
+  template <typename... Args>
+  value_type& emplace(std::uint64_t hash, Args&&... args)
+  {
+    const size_type mask = slots.size() - 1;
+    const size_type home = homeOf(hash);
+    size_type position = home;
+    GroupMask empty = Group(controls.data() + position).matchEmpty();
+    while(empty == 0) {
+      position = (position + Group::WIDTH) & mask;
+      empty = Group(controls.data() + position).matchEmpty();
+    }
+    const size_type free = (position + lowestBit(empty)) & mask;
+
+    size_type slot = home;
+    while(slot != free && distanceOf(slot) >= ((slot - home) & mask))
+      slot = (slot + 1) & mask;
+    for(size_type hole = free; hole != slot; ) {
+      const size_type previous = (hole - 1) & mask;
+      moveEntry(previous, hole);
+      hole = previous;
+    }
+    new (slots[slot].bytes) value_type(std::forward<Args>(args)...);
+    setControl(slot, fingerprintOf(hash));
+    return item(slot);
+  }
+
+  // backward shift: the entries after the slot that are not at home move one slot back
+  void erase(size_type slot)
+  {
+    const size_type mask = slots.size() - 1;
+    item(slot).~value_type();
+    for(size_type next = (slot + 1) & mask; isFull(next) && distanceOf(next) > 0; next = (next + 1) & mask) {
+      moveEntry(next, slot);
+      slot = next;
+    }
+    setControl(slot, control::EMPTY);
+    size--;
+  }
+
+  // to an empty or destroyed slot, leaving the control byte of the source for the caller to overwrite
+  void moveEntry(size_type from, size_type to)
+  {
+    new (slots[to].bytes) value_type(std::move(item(from)));
+    item(from).~value_type();
+    setControl(to, controls[from]);
+  }
+
+  void rehash()
+  {
+    FlatHashMap rehashed(2 * slots.size(), seed);
+    for(size_type slot = 0; slot < slots.size(); slot++)
+      if(isFull(slot))
+        rehashed.emplace(hashOf(item(slot).first), std::move(item(slot)));
+    rehashed.size = size;
+    swap(*this, rehashed);
+  }
+
+  void destroyItems()
+  {
+    for(size_type slot = 0; slot < slots.size(); slot++)
+      if(isFull(slot))
+        item(slot).~value_type();
+  }
+
+  // first full slot >= slot, slots.size() when there is none
+  size_type nextFrom(size_type slot) const
+  {
+    while(slot < slots.size() && !isFull(slot))
+      slot++;
+    return slot;
+  }
+
+  // last full slot < slot, slots.size() when there is none
+  size_type previousBefore(size_type slot) const
+  {
+    while(slot > 0)
+      if(isFull(--slot))
+        return slot;
+    return slots.size();
+  }
+};
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Group>
+class FlatHashMap<KeyType, ValueType, Hash, KeyEqual, Group>::ConstIterator
+{
+public:
+  using reference = typename FlatHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename FlatHashMap::value_type;
+  using pointer = const typename FlatHashMap::value_type*;
+
+  friend class FlatHashMap;
+
+  explicit ConstIterator() : position(0), map(nullptr)
+  {}
+
+  explicit ConstIterator(size_type position, const FlatHashMap& map) : position(position), map(&map)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(position >= map->slots.size())
+      throw std::out_of_range("cannot increment end");
+    position = map->nextFrom(position + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator old(*this);
+    operator++();
+    return old;
+  }
+
+  ConstIterator& operator--()
+  {
+    const size_type previous = map->previousBefore(position);
+    if(previous == map->slots.size())
+      throw std::out_of_range(map->isEmpty() ? "cannot decrement begin, empty map" : "cannot decrement begin");
+    position = previous;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator old(*this);
+    operator--();
+    return old;
+  }
+
+  reference operator*() const
+  {
+    if(position >= map->slots.size())
+      throw std::out_of_range("cannot dereference end");
+    return map->item(position);
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return position == other.position && map == other.map;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  size_type position; // a full slot, slots.size() for end
+  const FlatHashMap *map;
+};
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Group>
+class FlatHashMap<KeyType, ValueType, Hash, KeyEqual, Group>::Iterator
+  : public FlatHashMap<KeyType, ValueType, Hash, KeyEqual, Group>::ConstIterator
+{
+public:
+  using reference = typename FlatHashMap::reference;
+  using pointer = typename FlatHashMap::value_type*;
+
+  explicit Iterator()
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_FLATHASHMAP_H */
@@ -0,0 +1,404 @@
+#ifndef AISDI_MAPS_FLATMAP_H
+#define AISDI_MAPS_FLATMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ArrayView.h"
+#include "ArrowProxy.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+/*
+ * Keys and values in two vectors sorted by key - for small maps and maps built once and read many times:
+ * two allocations in total, keys packed densely for the binary search, iteration a linear scan.
+ * operator[] and remove() shift the tail of the vectors, O(n) - bulk insert() sorts and merges instead.
+ * Ordered like TreeMap (by operator< of the keys), with the same interface and the same exceptions.
+ *
+ * Keys and values live apart, so iterators dereference to a pair of references
+ * (it->first, it->second work as usual) and are invalidated by every insertion and removal.
+ */
+template <typename KeyType, typename ValueType>
+class FlatMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = std::pair<const key_type&, mapped_type&>;
+  using const_reference = std::pair<const key_type&, const mapped_type&>;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  FlatMap()
+  {}
+
+  FlatMap(std::initializer_list<value_type> list)
+  {
+    insert(list.begin(), list.end());
+  }
+
+  bool isEmpty() const
+  {
+    return keys.empty();
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    const size_type position = lowerBound(key);
+    if(position == keys.size() || key < keys[position]) {
+      keys.insert(keys.begin() + position, key);
+      try {
+        values.insert(values.begin() + position, mapped_type{});
+      } catch(...) {
+        keys.erase(keys.begin() + position); // the arrays stay of one length, or every later lookup is off
+        throw;
+      }
+    }
+    return values[position];
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    if(isEmpty())
+      throw std::out_of_range("map is empty");
+    const mapped_type* value = tryGet(key);
+    if(value == nullptr)
+      throw std::out_of_range("key does not exist");
+    return *value;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<mapped_type&>(static_cast<const FlatMap*>(this)->valueOf(key));
+  }
+
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    const size_type position = indexOf(key);
+    return position == keys.size() ? nullptr : &values[position];
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const FlatMap*>(this)->tryGet(key));
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(indexOf(key), *this);
+  }
+
+  iterator find(const key_type& key)
+  {
+    return ConstIterator(indexOf(key), *this);
+  }
+
+  /*
+   * Inserts pairs of [first, last), a later value of a repeated key wins like with operator[].
+   * The batch is merge sorted and merged with the map in one pass - O(n + m log m)
+   * instead of the O(n * m) of inserting the pairs one by one.
+   */
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last)
+  {
+    std::vector<std::pair<key_type, mapped_type>> batch(first, last);
+    std::stable_sort(batch.begin(), batch.end(), [](const auto& left, const auto& right) {
+      return left.first < right.first;
+    });
+    size_type unique = 0;
+    for(size_type i = 0; i < batch.size(); i++) {
+      if(unique != 0 && !(batch[unique - 1].first < batch[i].first))
+        batch[unique - 1].second = std::move(batch[i].second); // stable sort kept the later one last
+      else if(unique++ != i)
+        batch[unique - 1] = std::move(batch[i]);
+    }
+    batch.resize(unique);
+
+    std::vector<key_type> mergedKeys;
+    std::vector<mapped_type> mergedValues;
+    mergedKeys.reserve(keys.size() + batch.size());
+    mergedValues.reserve(keys.size() + batch.size());
+    size_type own = 0, added = 0;
+    while(own < keys.size() || added < batch.size()) {
+      if(added == batch.size() || (own < keys.size() && keys[own] < batch[added].first)) {
+        mergedKeys.push_back(std::move(keys[own]));
+        mergedValues.push_back(std::move(values[own++]));
+        continue;
+      }
+      if(own < keys.size() && !(batch[added].first < keys[own]))
+        own++; // replaced by the inserted value
+      mergedKeys.push_back(std::move(batch[added].first));
+      mergedValues.push_back(std::move(batch[added++].second));
+    }
+    keys.swap(mergedKeys);
+    values.swap(mergedValues);
+  }
+
+  void remove(const key_type& key)
+  {
+    if(isEmpty())
+      throw std::out_of_range("cannot remove, empty list");
+    const size_type position = indexOf(key);
+    if(position == keys.size())
+      throw std::out_of_range("cannot remove, element does not exist");
+    erase(position);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it == end())
+      throw std::out_of_range("cannot erase end");
+    erase(it.position);
+  }
+
+  size_type getSize() const
+  {
+    return keys.size();
+  }
+
+  // callback(ArrayView<const key_type>, ArrayView<const mapped_type>) once with both arrays, unless empty
+  template <typename Callback>
+  void forEachChunk(Callback callback) const
+  {
+    if(!isEmpty())
+      callback(ArrayView<const key_type>(keys.data(), keys.size()),
+               ArrayView<const mapped_type>(values.data(), values.size()));
+  }
+
+  // the key and the value arrays, with their spare capacity
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage;
+    if(keys.capacity() != 0)
+      usage.addBlocks(1, keys.capacity() * sizeof(key_type));
+    if(values.capacity() != 0)
+      usage.addBlocks(1, values.capacity() * sizeof(mapped_type));
+    usage.payloadBytes = keys.size() * sizeof(value_type);
+    return usage;
+  }
+
+  bool operator==(const FlatMap& other) const
+  {
+    return keys == other.keys && values == other.values;
+  }
+
+  bool operator!=(const FlatMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return cbegin();
+  }
+
+  iterator end()
+  {
+    return cend();
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(0, *this);
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(keys.size(), *this);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  std::vector<key_type> keys;
+  std::vector<mapped_type> values;
+
+  /*
+   * Branchless binary search: the range halves on every step whatever the comparison says,
+   * so the loop runs ceil(log2 n) times and the comparison turns into a conditional move -
+   * no mispredicted branches, which dominate std::lower_bound on random keys.
+   */
+  size_type lowerBound(const key_type& key) const
+  {
+    size_type length = keys.size();
+    if(length == 0)
+      return 0;
+    const key_type *base = keys.data();
+    while(length > 1) {
+      const size_type half = length / 2;
+      base = base[half] < key ? base + half : base;
+      length -= half;
+    }
+    return static_cast<size_type>(base - keys.data()) + (*base < key);
+  }
+
+  // position of the key, keys.size() when it is missing
+  size_type indexOf(const key_type& key) const
+  {
+    const size_type position = lowerBound(key);
+    if(position == keys.size() || key < keys[position])
+      return keys.size();
+    return position;
+  }
+
+  void erase(size_type position)
+  {
+    keys.erase(keys.begin() + position);
+    values.erase(values.begin() + position);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class FlatMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename FlatMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename FlatMap::value_type;
+  using difference_type = std::ptrdiff_t;
+
+  using pointer = ArrowProxy<reference>;
+
+  friend class FlatMap;
+
+  explicit ConstIterator() : position(0), map(nullptr)
+  {}
+
+  explicit ConstIterator(size_type position, const FlatMap& map) : position(position), map(&map)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(position >= map->keys.size())
+      throw std::out_of_range("cannot increment end");
+    position++;
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator old(*this);
+    operator++();
+    return old;
+  }
+
+  ConstIterator& operator--()
+  {
+    if(position == 0)
+      throw std::out_of_range(map->isEmpty() ? "cannot decrement begin, empty map" : "cannot decrement begin");
+    position--;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator old(*this);
+    operator--();
+    return old;
+  }
+
+  reference operator*() const
+  {
+    if(position >= map->keys.size())
+      throw std::out_of_range("cannot dereference end");
+    return reference(map->keys[position], map->values[position]);
+  }
+
+  pointer operator->() const
+  {
+    return pointer(operator*());
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return position == other.position && map == other.map;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+
+protected:
+  size_type position; // keys.size() for end
+  const FlatMap *map;
+};
+
+template <typename KeyType, typename ValueType>
+class FlatMap<KeyType, ValueType>::Iterator : public FlatMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename FlatMap::reference;
+  using pointer = ArrowProxy<reference>;
+
+  explicit Iterator()
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return pointer(operator*());
+  }
+
+  reference operator*() const
+  {
+    const auto item = ConstIterator::operator*();
+    // ugly cast, yet reduces code duplication.
+    return reference(item.first, const_cast<mapped_type&>(item.second));
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_FLATMAP_H */
@@ -0,0 +1,467 @@
+#ifndef AISDI_MAPS_FROZENHASHMAP_H
+#define AISDI_MAPS_FROZENHASHMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Hash.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+/*
+ * An immutable map for tables loaded once and then only read, made by build() from any range of pairs
+ * (a HashMap, a TreeMap, a vector of pairs...). The keys get a minimal perfect hash in the style of PTHash:
+ * a key's hash picks one of n / BUCKET_SIZE buckets, the bucket's pilot - found at build time so that
+ * the keys of all buckets land in distinct slots - turns the hash into the key's slot among the n entries.
+ * A lookup reads the pilot and the entry, with no chains and a single key comparison.
+ *
+ * Slots are searched in a table a few percent larger than n, which keeps the pilot search short;
+ * keys that land in the extra slots are moved to the free slots below n and found through a small
+ * remap array - a third memory access for about one key in twenty.
+ *
+ * Keys the hasher cannot tell apart (a full hash equal to that of another key) would need the same slot
+ * for every seed; they are kept after the hashed entries and searched linearly when a lookup lands on
+ * a key with the same hash.
+ *
+ * Entries are stored in slot order, so iteration order is unspecified. Everything is const -
+ * there is no operator[] and no remove(), iterators cannot change values.
+ */
+template <typename KeyType, typename ValueType,
+          typename Hash = aisdi::Hash<KeyType>, typename KeyEqual = aisdi::EqualTo<KeyType>>
+class FrozenHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using reference = const value_type&;
+  using const_reference = const value_type&;
+
+  class ConstIterator;
+  using iterator = ConstIterator;
+  using const_iterator = ConstIterator;
+
+  static const std::size_t BUCKET_SIZE = 4; // average keys per pilot
+  static const std::size_t EXTRA_SLOTS_PER_100 = 5;
+  static const std::uint32_t MAX_PILOT = std::numeric_limits<std::uint16_t>::max();
+  static const int MAX_SEEDS = 16; // build() gives up after so many failed pilot searches
+
+  FrozenHashMap() : hashedSize(0), seed(0)
+  {}
+
+  FrozenHashMap(const FrozenHashMap& other) = default;
+  FrozenHashMap(FrozenHashMap&& other) = default;
+
+  // entries have const keys and cannot be assigned, the arrays are swapped instead
+  FrozenHashMap& operator=(FrozenHashMap other)
+  {
+    entries.swap(other.entries);
+    pilots.swap(other.pilots);
+    remap.swap(other.remap);
+    std::swap(hashedSize, other.hashedSize);
+    std::swap(seed, other.seed);
+    return *this;
+  }
+
+  /*
+   * Builds the map from pairs of [first, last), in a few hundred ns per key - less than inserting them into a HashMap.
+   * Throws std::invalid_argument for a repeated key or when no seed gives a perfect hash within MAX_SEEDS tries
+   * (not to be expected from any sensible hasher), and std::length_error past 2^32 - 1 keys.
+   */
+  template <typename InputIterator>
+  static FrozenHashMap build(InputIterator first, InputIterator last)
+  {
+    std::vector<std::pair<key_type, mapped_type>> items;
+    for( ; first != last; ++first)
+      items.emplace_back(first->first, first->second);
+    if(items.size() >= std::numeric_limits<std::uint32_t>::max())
+      throw std::length_error("too many keys for a FrozenHashMap");
+
+    FrozenHashMap map;
+    std::vector<std::uint32_t> owners; // index into items of the key in each slot
+    std::vector<std::pair<key_type, mapped_type>> collided; // keys taken out of items, found linearly
+    int seeds = 0;
+    while(!map.placeKeys(items, owners, collided)) {
+      // a pilot search failed, start over with another seed
+      if(++seeds == MAX_SEEDS)
+        throw std::invalid_argument("cannot build FrozenHashMap, no perfect hash found");
+    }
+    map.hashedSize = items.size();
+    map.entries.reserve(items.size() + collided.size());
+    for(const auto owner : owners)
+      map.entries.emplace_back(std::move(items[owner].first), std::move(items[owner].second));
+    for(auto& item : collided)
+      map.entries.emplace_back(std::move(item.first), std::move(item.second));
+    return map;
+  }
+
+  template <typename Range>
+  static FrozenHashMap build(const Range& range)
+  {
+    using std::begin;
+    using std::end;
+    return build(begin(range), end(range));
+  }
+
+  bool isEmpty() const
+  {
+    return entries.empty();
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    if(isEmpty())
+      throw std::out_of_range("empty map, cannot get value");
+    const value_type *entry = findEntry(key);
+    if(entry == nullptr)
+      throw std::out_of_range("element with given key does not exist");
+    return entry->second;
+  }
+
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    const value_type *entry = findEntry(key);
+    return entry == nullptr ? nullptr : &entry->second;
+  }
+
+  template <typename SearchedKey, typename H = hasher, typename E = key_equal,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  const mapped_type* tryGet(const SearchedKey& key) const
+  {
+    const value_type *entry = findEntry(key);
+    return entry == nullptr ? nullptr : &entry->second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return iteratorTo(findEntry(key));
+  }
+
+  // heterogeneous lookup (e.g. find(std::string_view) in FrozenHashMap<std::string, V>), as in HashMap
+  template <typename SearchedKey, typename H = hasher, typename E = key_equal,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  const_iterator find(const SearchedKey& key) const
+  {
+    return iteratorTo(findEntry(key));
+  }
+
+  size_type getSize() const
+  {
+    return entries.size();
+  }
+
+  // the entries, the pilots and the remap array - three blocks whatever the size
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage;
+    if(entries.capacity() != 0)
+      usage.addBlocks(1, entries.capacity() * sizeof(value_type));
+    if(pilots.capacity() != 0)
+      usage.addBlocks(1, pilots.capacity() * sizeof(std::uint16_t));
+    if(remap.capacity() != 0)
+      usage.addBlocks(1, remap.capacity() * sizeof(std::uint32_t));
+    usage.payloadBytes = entries.size() * sizeof(value_type);
+    return usage;
+  }
+
+  bool operator==(const FrozenHashMap& other) const
+  {
+    if(getSize() != other.getSize())
+      return false;
+    for(const auto& element : other) {
+      const mapped_type *value = tryGet(element.first);
+      if(value == nullptr || !(*value == element.second))
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const FrozenHashMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(0, *this);
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(entries.size(), *this);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  std::vector<value_type> entries; // in slot order
+  std::vector<std::uint16_t> pilots; // one per bucket
+  std::vector<std::uint32_t> remap; // slot below hashedSize for each of the extra slots
+  size_type hashedSize; // entries found through the pilots, the collided ones follow
+  std::uint64_t seed;
+
+  // r * x / 2^32 - maps 32 bits of x onto [0, r) evenly, without a division
+  static std::size_t reduce(std::uint64_t x, std::size_t range)
+  {
+    return static_cast<std::size_t>(((x & 0xffffffffull) * range) >> 32);
+  }
+
+  template <typename SearchedKey>
+  std::uint64_t hashOf(const SearchedKey& key) const
+  {
+    return seededHash<hasher>(key, seed);
+  }
+
+  std::size_t bucketOf(std::uint64_t hash) const
+  {
+    return reduce(hash >> 32, pilots.size());
+  }
+
+  static std::size_t slotOf(std::uint64_t hash, std::uint32_t pilot, std::size_t tableSize)
+  {
+    return reduce(mixBits(hash ^ (pilot * 0x9e3779b97f4a7c15ull)), tableSize);
+  }
+
+  template <typename SearchedKey>
+  const value_type* findEntry(const SearchedKey& key) const
+  {
+    if(isEmpty())
+      return nullptr;
+    const std::uint64_t hash = hashOf(key);
+    std::size_t slot = slotOf(hash, pilots[bucketOf(hash)], hashedSize + remap.size());
+    if(slot >= hashedSize)
+      slot = remap[slot - hashedSize];
+    const value_type& entry = entries[slot];
+    if(key_equal{}(entry.first, key))
+      return &entry;
+    if(hashedSize == entries.size() || hashOf(entry.first) != hash)
+      return nullptr;
+    for(size_type position = hashedSize; position < entries.size(); position++)
+      if(key_equal{}(entries[position].first, key))
+        return &entries[position];
+    return nullptr;
+  }
+
+  const_iterator iteratorTo(const value_type* entry) const
+  {
+    return entry == nullptr ? cend() : ConstIterator(static_cast<size_type>(entry - entries.data()), *this);
+  }
+
+  /*
+   * Finds the pilots and the remap for the keys of items, owners[slot] becomes the item in the slot.
+   * Buckets are placed from the largest, while most slots are still free. Returns false when some bucket
+   * found no pilot within MAX_PILOT tries - another seed is needed - or when keys with the same 64-bit hash
+   * as another key were moved from items to collided: mixBits() is a bijection, so they share the hash
+   * of the hasher and collide for every seed. entries stays empty, the caller fills it.
+   */
+  bool placeKeys(std::vector<std::pair<key_type, mapped_type>>& items, std::vector<std::uint32_t>& owners,
+                 std::vector<std::pair<key_type, mapped_type>>& collided)
+  {
+    const std::size_t size = items.size();
+    const std::size_t tableSize = size + (size * EXTRA_SLOTS_PER_100 + 99) / 100;
+    seed = randomSeed();
+    pilots.assign(size / BUCKET_SIZE + 1, 0);
+    remap.assign(tableSize - size, 0);
+    entries.clear();
+
+    // keys and their hashes grouped by bucket, so that the hashes of a bucket are read from one place
+    std::vector<std::uint64_t> hashes(size);
+    std::vector<std::uint32_t> bucketStart(pilots.size() + 1, 0);
+    for(std::size_t i = 0; i < size; i++) {
+      hashes[i] = hashOf(items[i].first);
+      bucketStart[bucketOf(hashes[i]) + 1]++;
+    }
+    std::size_t largestBucket = 0;
+    for(std::size_t bucket = 0; bucket < pilots.size(); bucket++) {
+      largestBucket = std::max<std::size_t>(largestBucket, bucketStart[bucket + 1]);
+      bucketStart[bucket + 1] += bucketStart[bucket];
+    }
+    std::vector<std::uint32_t> keysByBucket(size);
+    std::vector<std::uint64_t> hashesByBucket(size);
+    std::vector<std::uint32_t> filled(bucketStart.begin(), bucketStart.end() - 1);
+    for(std::size_t i = 0; i < size; i++) {
+      const std::uint32_t position = filled[bucketOf(hashes[i])]++;
+      keysByBucket[position] = static_cast<std::uint32_t>(i);
+      hashesByBucket[position] = hashes[i];
+    }
+    hashes = std::vector<std::uint64_t>();
+
+    // keys with equal hashes are in the same bucket; all but the first of them are taken out
+    std::vector<bool> isCollided(size, false);
+    bool anyCollided = false;
+    for(std::size_t bucket = 0; bucket < pilots.size(); bucket++)
+      for(std::size_t j = bucketStart[bucket]; j < bucketStart[bucket + 1]; j++)
+        for(std::size_t i = bucketStart[bucket]; i < j; i++)
+          if(hashesByBucket[i] == hashesByBucket[j]) {
+            if(key_equal{}(items[keysByBucket[i]].first, items[keysByBucket[j]].first))
+              throw std::invalid_argument("cannot build FrozenHashMap, repeated key");
+            isCollided[keysByBucket[j]] = true;
+            anyCollided = true;
+          }
+    if(anyCollided) {
+      std::size_t kept = 0;
+      for(std::size_t i = 0; i < size; i++) {
+        if(isCollided[i])
+          collided.push_back(std::move(items[i]));
+        else if(kept++ != i)
+          items[kept - 1] = std::move(items[i]);
+      }
+      items.resize(kept);
+      return false;
+    }
+
+    // buckets from the largest - counting sort by size
+    std::vector<std::uint32_t> sizeStart(largestBucket + 2, 0);
+    for(std::size_t bucket = 0; bucket < pilots.size(); bucket++)
+      sizeStart[largestBucket - (bucketStart[bucket + 1] - bucketStart[bucket]) + 1]++;
+    for(std::size_t i = 1; i < sizeStart.size(); i++)
+      sizeStart[i] += sizeStart[i - 1];
+    std::vector<std::uint32_t> bucketOrder(pilots.size());
+    for(std::size_t bucket = 0; bucket < pilots.size(); bucket++)
+      bucketOrder[sizeStart[largestBucket - (bucketStart[bucket + 1] - bucketStart[bucket])]++] =
+        static_cast<std::uint32_t>(bucket);
+
+    // a bit per slot, so that the slots tried stay in cache - owners is written only once a bucket fits
+    std::vector<std::uint64_t> taken((tableSize + 63) / 64, 0);
+    auto isTaken = [&](std::size_t slot) { return (taken[slot / 64] >> (slot % 64)) & 1; };
+    auto flip = [&](std::size_t slot) { taken[slot / 64] ^= std::uint64_t(1) << (slot % 64); };
+    owners.assign(tableSize, 0);
+    std::vector<std::size_t> slots(largestBucket);
+    for(const auto bucket : bucketOrder) {
+      const std::uint32_t *keys = keysByBucket.data() + bucketStart[bucket];
+      const std::uint64_t *keyHashes = hashesByBucket.data() + bucketStart[bucket];
+      const std::size_t count = bucketStart[bucket + 1] - bucketStart[bucket];
+      if(count == 0)
+        break;
+      std::uint32_t pilot = 0;
+      for( ; ; pilot++) {
+        if(pilot > MAX_PILOT)
+          return false;
+        std::size_t placed = 0;
+        for( ; placed < count; placed++) {
+          slots[placed] = slotOf(keyHashes[placed], pilot, tableSize);
+          if(isTaken(slots[placed]))
+            break;
+          flip(slots[placed]); // taken already, so that keys of a bucket do not collide
+        }
+        if(placed == count)
+          break;
+        while(placed-- > 0)
+          flip(slots[placed]);
+      }
+      for(std::size_t i = 0; i < count; i++)
+        owners[slots[i]] = keys[i];
+      pilots[bucket] = static_cast<std::uint16_t>(pilot);
+    }
+
+    // keys in the extra slots move to the free slots below size
+    std::size_t freeSlot = 0;
+    for(std::size_t slot = size; slot < tableSize; slot++) {
+      if(!isTaken(slot))
+        continue;
+      while(isTaken(freeSlot))
+        freeSlot++;
+      owners[freeSlot] = owners[slot];
+      remap[slot - size] = static_cast<std::uint32_t>(freeSlot++);
+    }
+    owners.resize(size);
+    return true;
+  }
+};
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+class FrozenHashMap<KeyType, ValueType, Hash, KeyEqual>::ConstIterator
+{
+public:
+  using reference = typename FrozenHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename FrozenHashMap::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const typename FrozenHashMap::value_type*;
+
+  explicit ConstIterator() : position(0), map(nullptr)
+  {}
+
+  explicit ConstIterator(size_type position, const FrozenHashMap& map) : position(position), map(&map)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(position >= map->entries.size())
+      throw std::out_of_range("cannot increment end");
+    position++;
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator old(*this);
+    operator++();
+    return old;
+  }
+
+  ConstIterator& operator--()
+  {
+    if(position == 0)
+      throw std::out_of_range(map->isEmpty() ? "cannot decrement begin, empty map" : "cannot decrement begin");
+    position--;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator old(*this);
+    operator--();
+    return old;
+  }
+
+  reference operator*() const
+  {
+    if(position >= map->entries.size())
+      throw std::out_of_range("cannot dereference end");
+    return map->entries[position];
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return position == other.position && map == other.map;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  size_type position; // into the entries, size for end
+  const FrozenHashMap *map;
+};
+
+}
+
+#endif /* AISDI_MAPS_FROZENHASHMAP_H */
@@ -0,0 +1,165 @@
+#ifndef AISDI_MAPS_HASH_H
+#define AISDI_MAPS_HASH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace aisdi
+{
+
+// Folds the 128-bit product of a and b into 64 bits (the core step of wyhash).
+inline std::uint64_t multiplyFold(std::uint64_t a, std::uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 uint128;
+  const uint128 product = static_cast<uint128>(a) * b;
+  return static_cast<std::uint64_t>(product >> 64) ^ static_cast<std::uint64_t>(product);
+#else
+  const std::uint64_t aLow = a & 0xffffffffull, aHigh = a >> 32;
+  const std::uint64_t bLow = b & 0xffffffffull, bHigh = b >> 32;
+  const std::uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh;
+  const std::uint64_t highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+  const std::uint64_t middle = (lowLow >> 32) + (lowHigh & 0xffffffffull) + (highLow & 0xffffffffull);
+  const std::uint64_t low = (middle << 32) | (lowLow & 0xffffffffull);
+  const std::uint64_t high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+  return high ^ low;
+#endif
+}
+
+// Scrambles all bits of x, so that keys differing only in their high bits (strides) spread evenly.
+inline std::uint64_t mixBits(std::uint64_t x)
+{
+  return multiplyFold(x ^ 0xa0761d6478bd642full, 0xe7037ed1a0b428dbull);
+}
+
+// reads up to 8 bytes as one word, missing bytes are zero
+inline std::uint64_t readWord(const char* data, std::size_t length)
+{
+  std::uint64_t word = 0;
+  std::memcpy(&word, data, length < 8 ? length : 8);
+  return word;
+}
+
+/*
+ * wyhash style hash of a byte range, 16 bytes per multiplication. The seed goes into both factors
+ * of every fold: a word that zeroes a factor - and so the whole hash - depends on it.
+ */
+inline std::uint64_t hashBytes(const char* data, std::size_t length, std::uint64_t seed = 0)
+{
+  const std::uint64_t secret = 0x589965cc75374cc3ull ^ seed;
+  std::uint64_t hash = 0x8ebc6af09c88c6e3ull ^ length ^ seed;
+  for( ; length > 16; data += 16, length -= 16)
+    hash = multiplyFold(readWord(data, 8) ^ secret, readWord(data + 8, 8) ^ hash);
+  const std::uint64_t first = readWord(data, length);
+  const std::uint64_t second = length > 8 ? readWord(data + 8, length - 8) : 0;
+  return multiplyFold(first ^ secret, second ^ hash);
+}
+
+// Different on every call and in every run of the program, used to seed hashing of each map.
+inline std::uint64_t randomSeed()
+{
+  static const std::uint64_t processSeed = mixBits((static_cast<std::uint64_t>(std::random_device{}()) << 32)
+    ^ std::random_device{}()
+    ^ static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+  static std::atomic<std::uint64_t> counter(0);
+  return mixBits(processSeed + 0x9e3779b97f4a7c15ull * ++counter);
+}
+
+// Keys hashed about as fast as they are compared - caching their hashes in map entries does not pay off.
+template <typename KeyType>
+struct IsFastToHash : std::integral_constant<bool, std::is_arithmetic<KeyType>::value
+                                                   || std::is_enum<KeyType>::value
+                                                   || std::is_pointer<KeyType>::value>
+{};
+
+/*
+ * Default hash of the maps. Falls back to std::hash, except for integral and enum keys,
+ * for which std::hash usually is the identity - those are run through mixBits(),
+ * so the low bits used for picking a bucket depend on the whole key.
+ */
+template <typename KeyType, typename Enable = void>
+struct Hash : std::hash<KeyType>
+{};
+
+template <typename KeyType>
+struct Hash<KeyType, typename std::enable_if<std::is_integral<KeyType>::value
+                                             || std::is_enum<KeyType>::value>::type>
+{
+  std::size_t operator()(KeyType key) const
+  {
+    return static_cast<std::size_t>(mixBits(static_cast<std::uint64_t>(key)));
+  }
+};
+
+// Transparent - std::string, std::string_view and C strings with the same characters hash alike.
+template <>
+struct Hash<std::string>
+{
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view key) const
+  {
+    return static_cast<std::size_t>(hashBytes(key.data(), key.size()));
+  }
+
+  std::size_t operator()(std::string_view key, std::uint64_t seed) const
+  {
+    return static_cast<std::size_t>(hashBytes(key.data(), key.size(), seed));
+  }
+};
+
+template <>
+struct Hash<std::string_view> : Hash<std::string>
+{};
+
+// Hashers callable as hasher(key, seed), which mix the seed of a map in from the first step.
+template <typename Hasher, typename KeyType, typename = void>
+struct IsSeededHash : std::false_type
+{};
+
+template <typename Hasher, typename KeyType>
+struct IsSeededHash<Hasher, KeyType, std::void_t<decltype(std::declval<const Hasher&>()(
+  std::declval<const KeyType&>(), std::uint64_t()))>> : std::true_type
+{};
+
+/*
+ * Hash of key in a map seeded with seed. Plain hashers get the seed XORed into their result only,
+ * so keys with equal results collide in every map; seeded ones are given it as well.
+ */
+template <typename Hasher, typename KeyType>
+std::uint64_t seededHash(const KeyType& key, std::uint64_t seed)
+{
+  if constexpr(IsSeededHash<Hasher, KeyType>::value)
+    return mixBits(static_cast<std::uint64_t>(Hasher{}(key, seed)) ^ seed);
+  else
+    return mixBits(static_cast<std::uint64_t>(Hasher{}(key)) ^ seed);
+}
+
+/*
+ * Default key equality of the maps, std::equal_to except for strings,
+ * which are compared transparently, so they can be looked up by std::string_view or const char*.
+ */
+template <typename KeyType>
+struct EqualTo : std::equal_to<KeyType>
+{};
+
+template <>
+struct EqualTo<std::string> : std::equal_to<>
+{};
+
+template <>
+struct EqualTo<std::string_view> : std::equal_to<>
+{};
+
+}
+
+#endif /* AISDI_MAPS_HASH_H */
@@ -2,45 +2,146 @@
 #define AISDI_MAPS_HASHMAP_H
 
 #include <cstddef>
+#include <cstdint>
+#include <algorithm>
 #include <initializer_list>
+#include <new>
 #include <stdexcept>
 #include <utility>
 #include <functional>
-#include <array>
+#include <type_traits>
+#include <vector>
+
+#include "ArrayView.h"
+#include "Hash.h"
+#include "InlineEntries.h"
+#include "InterleavedLookup.h"
+#include "MapStats.h"
+#include "MemoryUsage.h"
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
-class HashMap
+// Full hash of a HashMap entry, stored next to it when hashes are cached.
+template <bool IsCached>
+class CachedHash
+{
+public:
+  void setHash(std::size_t newHash)
+  {
+    hash = newHash;
+  }
+
+  std::size_t getHash() const
+  {
+    return hash;
+  }
+
+  // false means the keys certainly differ, true that they have to be compared
+  bool mayMatch(std::size_t otherHash) const
+  {
+    return hash == otherHash;
+  }
+
+private:
+  std::size_t hash;
+};
+
+template <>
+class CachedHash<false>
+{
+public:
+  void setHash(std::size_t)
+  {}
+
+  bool mayMatch(std::size_t) const
+  {
+    return true;
+  }
+};
+
+/*
+ * True when operator< of the keys agrees with KeyEqual (the default equality of a key that has operator<),
+ * so that keys of equal hash in a treeified HashMap chain can be ordered; otherwise they are compared
+ * with KeyEqual one by one.
+ */
+template <typename KeyType, typename KeyEqual, typename = void>
+struct OrdersLikeKeyEqual : std::false_type
+{};
+
+template <typename KeyType, typename KeyEqual>
+struct OrdersLikeKeyEqual<KeyType, KeyEqual,
+                          std::void_t<decltype(std::declval<const KeyType&>() < std::declval<const KeyType&>())>>
+  : std::integral_constant<bool, std::is_same<KeyEqual, EqualTo<KeyType>>::value
+                                 || std::is_same<KeyEqual, std::equal_to<KeyType>>::value
+                                 || std::is_same<KeyEqual, std::equal_to<>>::value>
+{};
+
+// Occupancy of the buckets of a HashMap, see HashMap::bucketHistogram().
+struct BucketHistogram
+{
+  std::size_t buckets = 0;
+  std::size_t emptyBuckets = 0;
+  std::size_t treeifiedBuckets = 0; // chains that grew past the threshold and are searched through a tree
+  std::size_t maxChain = 0;
+  std::vector<std::size_t> chainLengths; // chainLengths[n] - number of buckets holding n entries, up to maxChain
+};
+
+/*
+ * Hash and KeyEqual are default constructed whenever they are needed, so they have to be stateless.
+ * With CacheHash every entry keeps its full hash, which is compared before the keys
+ * and reused when the table grows - by default only for keys that are slow to hash.
+ * Stats is NoStats or CountingStats, see MapStats.h.
+ *
+ * With InlineCapacity the first that many entries live inside the map object and are searched linearly -
+ * no bucket array, no sentinels, no allocation at all until the entry that does not fit moves them all
+ * into the table (for good, the table stays when the map shrinks). Meant for many tiny maps,
+ * at the price of a bigger object. 0, the default, leaves the map exactly as without it.
+ */
+template <typename KeyType, typename ValueType,
+          typename Hash = aisdi::Hash<KeyType>, typename KeyEqual = aisdi::EqualTo<KeyType>,
+          bool CacheHash = !IsFastToHash<KeyType>::value, typename Stats = NoStats, std::size_t InlineCapacity = 0>
+class HashMap : private Stats, private InlineEntries<std::pair<const KeyType, ValueType>, InlineCapacity>
 {
 public:
   using key_type = KeyType;
   using mapped_type = ValueType;
   using value_type = std::pair<const key_type, mapped_type>;
   using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
   using reference = value_type&;
   using const_reference = const value_type&;
 
   class ConstIterator;
   class Iterator;
   class SinglyLinkedList;
+  class LookupCursor;
   using iterator = Iterator;
   using const_iterator = ConstIterator;
 
-  HashMap() : size(0)
-  {}
+  static const size_type CHUNK_SIZE = 64; // entries per batch of forEachChunk()
+
+  HashMap() : buckets(InlineCapacity > 0 ? 0 : MIN_NO_OF_BUCKETS), size(0), seed(randomSeed())
+  {
+    if(!isInline())
+      Stats::allocation(MIN_NO_OF_BUCKETS + 1);
+  }
 
-  HashMap(std::initializer_list<value_type> list) : size(0)
+  HashMap(std::initializer_list<value_type> list) : HashMap()
   {
     for(auto element: list)
       operator[](element.first) = element.second;
   }
 
-  HashMap(const HashMap& other) : size(other.size)
+  HashMap(const HashMap& other)
+    : Stats(), Inline(other), buckets(other.buckets), size(other.size), seed(other.seed)
   {
-    for(int i = 0; i < NO_OF_BUCKETS; i++)
-      buckets[i] = other.buckets[i];
+    if constexpr(Stats::enabled)
+      if(!isInline()) {
+        Stats::allocation(buckets.size() + 1 + size);
+        countTreeifiedBuckets();
+      }
   }
 
   HashMap(HashMap&& other) : HashMap()
@@ -61,6 +162,9 @@ public:
     using std::swap;
     swap(first.buckets, second.buckets);
     swap(first.size, second.size);
+    swap(first.seed, second.seed);
+    if constexpr(InlineCapacity > 0)
+      first.swapInline(second);
   }
 
   ~HashMap()
@@ -75,22 +179,28 @@ public:
 
   mapped_type& operator[](const key_type& key)
   {
-    /*
-     ASK - is code with try&catch slower?
-
-    try {
-      return buckets[getHash(key)].getDataForKey(key).second;
-    } catch(std::out_of_range e) {
-      size++;
-      return buckets[getHash(key)].append(key);
-    }*/
-
-    if(buckets[getHash(key)].isKeyPresent(key))
-      return buckets[getHash(key)].getDataForKey(key).second;
-    if(isEmpty() || key < smallestKey)
-      smallestKey = key;
+    if constexpr(InlineCapacity > 0)
+      if(isInline()) {
+        const size_type index = inlineIndexOf(key);
+        if(index < size)
+          return this->inlineItem(index).second;
+        if(size < InlineCapacity) {
+          value_type& item = this->emplaceInline(key, mapped_type{});
+          size++;
+          return item.second;
+        }
+        spill();
+      }
+    const std::size_t hash = hashOf(key);
+    if(DataNode *node = buckets[bucketOf(hash)].findNode(key, hash, statistics()))
+      return node->data.second;
+    if(size >= buckets.size()) // keep the load factor at most 1
+      rehash(2 * buckets.size());
     size++;
-    return buckets[getHash(key)].append(key);
+    SinglyLinkedList& bucket = buckets[bucketOf(hash)];
+    if constexpr(Stats::enabled)
+      countAppend(bucket);
+    return bucket.append(key, hash, *this);
   }
 
   const mapped_type& valueOf(const key_type& key) const
@@ -98,15 +208,45 @@ public:
     if(isEmpty())
       throw std::out_of_range("empty map, cannot get value");
 
-    return buckets[getHash(key)].getDataForKey(key).second;
+    const mapped_type *value = findValue(key);
+    if(value == nullptr)
+      throw std::out_of_range("element with given key does not exist");
+    return *value;
   }
 
   mapped_type& valueOf(const key_type& key)
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<mapped_type&>(static_cast<const HashMap*>(this)->valueOf(key));
+  }
+
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  const mapped_type* tryGet(const key_type& key) const
   {
     if(isEmpty())
-      throw std::out_of_range("empty map, cannot get value");
+      return nullptr;
+    return findValue(key);
+  }
 
-    return buckets[getHash(key)].getDataForKey(key).second;
+  mapped_type* tryGet(const key_type& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const HashMap*>(this)->tryGet(key));
+  }
+
+  template <typename SearchedKey, typename H = hasher, typename E = key_equal,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  const mapped_type* tryGet(const SearchedKey& key) const
+  {
+    if(isEmpty())
+      return nullptr;
+    return findValue(key);
+  }
+
+  template <typename SearchedKey, typename H = hasher, typename E = key_equal,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  mapped_type* tryGet(const SearchedKey& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const HashMap*>(this)->tryGet(key));
   }
 
   const_iterator find(const key_type& key) const
@@ -123,22 +263,62 @@ public:
     return search(key);
   }
 
+  // heterogeneous lookup (e.g. find(std::string_view) in HashMap<std::string, V>), needs transparent Hash and KeyEqual
+  template <typename SearchedKey, typename H = hasher, typename E = key_equal,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  const_iterator find(const SearchedKey& key) const
+  {
+    if(isEmpty())
+      return cend();
+    return search(key);
+  }
+
+  template <typename SearchedKey, typename H = hasher, typename E = key_equal,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  iterator find(const SearchedKey& key)
+  {
+    if(isEmpty())
+      return end();
+    return search(key);
+  }
+
+  // key has to outlive the cursor, see interleavedFind() in InterleavedLookup.h
+  LookupCursor startLookup(const key_type& key) const
+  {
+    return LookupCursor(key, *this);
+  }
+
   void remove(const key_type& key)
   {
     if(isEmpty())
       throw std::out_of_range("cannot remove, empty list");
+    if constexpr(InlineCapacity > 0)
+      if(isInline()) {
+        const size_type index = inlineIndexOf(key);
+        if(index == size)
+          throw std::out_of_range("cannot remove, element does not exist");
+        this->removeInline(index);
+        size--;
+        return;
+      }
 
-    buckets[getHash(key)].remove(key);
+    const std::size_t hash = hashOf(key);
+    SinglyLinkedList& bucket = buckets[bucketOf(hash)];
+    const bool wasTreeified = bucket.isTreeified();
+    bucket.remove(key, hash, statistics());
     size--;
-    if(smallestKey == key && !isEmpty())
-      smallestKey = getSmallestKey();
+    if constexpr(Stats::enabled)
+      if(wasTreeified && !bucket.isTreeified()) {
+        Stats::rebalance();
+        Stats::allocation(bucket.length);
+      }
   }
 
   void remove(const const_iterator& it)
   {
-    if(it.currentKeyBucket == -1)
+    if(it == cend())
       throw std::out_of_range("cannot remove end");
-    remove(it.currentKey);
+    remove(it->first);
   }
 
   size_type getSize() const
@@ -146,6 +326,82 @@ public:
     return size;
   }
 
+  // true while the entries live inside the object, see InlineCapacity
+  bool isInline() const
+  {
+    return InlineCapacity > 0 && buckets.empty();
+  }
+
+  /*
+   * Hands all entries to callback(ArrayView<const value_type* const>) in batches of up to CHUNK_SIZE,
+   * in iteration order - the chains of consecutive buckets gathered without the checks of ConstIterator,
+   * so the consumer loops over a plain array. Entries live in separate nodes, hence pointers.
+   */
+  template <typename Callback>
+  void forEachChunk(Callback callback) const
+  {
+    const value_type *chunk[CHUNK_SIZE];
+    size_type count = 0;
+    auto add = [&](const value_type *entry) {
+      chunk[count++] = entry;
+      if(count == CHUNK_SIZE) {
+        callback(ArrayView<const value_type* const>(chunk, count));
+        count = 0;
+      }
+    };
+    if constexpr(InlineCapacity > 0)
+      if(isInline())
+        for(size_type index = 0; index < size; index++)
+          add(&Inline::inlineItem(index));
+    for(const SinglyLinkedList& bucket : buckets)
+      for(const Node *node = bucket.head->next; node != nullptr; node = node->next)
+        add(&static_cast<const DataNode*>(node)->data);
+    if(count != 0)
+      callback(ArrayView<const value_type* const>(chunk, count));
+  }
+
+  // heap memory of the bucket array, the sentinel heads of the buckets and the nodes - none while inline
+  MemoryUsage memoryUsage() const
+  {
+    using TreeNode = typename SinglyLinkedList::TreeNode;
+    MemoryUsage usage;
+    if(isInline())
+      return usage;
+    usage.addBlocks(1, buckets.capacity() * sizeof(SinglyLinkedList));
+    for(const auto& bucket : buckets) {
+      usage.addBlocks(1, sizeof(Node));
+      usage.addBlocks(bucket.length, bucket.isTreeified() ? sizeof(TreeNode) : sizeof(DataNode));
+    }
+    usage.payloadBytes = size * sizeof(value_type);
+    return usage;
+  }
+
+  // counted since construction, all zero unless Stats is CountingStats
+  MapStats stats() const
+  {
+    return Stats::snapshot();
+  }
+
+  /*
+   * One pass over the buckets, O(number of buckets). With a good hash and the load factor at most 1
+   * chain lengths are roughly Poisson distributed - long chains or many empty buckets next to full ones
+   * mean keys the hash does not spread.
+   */
+  BucketHistogram bucketHistogram() const
+  {
+    BucketHistogram histogram;
+    histogram.buckets = buckets.size();
+    for(const auto& bucket : buckets) {
+      if(bucket.length >= histogram.chainLengths.size())
+        histogram.chainLengths.resize(bucket.length + 1, 0);
+      histogram.chainLengths[bucket.length]++;
+      histogram.maxChain = std::max(histogram.maxChain, bucket.length);
+      histogram.emptyBuckets += bucket.length == 0;
+      histogram.treeifiedBuckets += bucket.isTreeified();
+    }
+    return histogram;
+  }
+
   bool operator==(const HashMap& other) const
   {
     if(size != other.size)
@@ -178,16 +434,15 @@ public:
   const_iterator cbegin() const
   {
     if(isEmpty())
-      return ConstIterator(0, -1, *this);
-    else {
-      key_type key = smallestKey;
-      return ConstIterator(key, *this);
-    }
+      return cend();
+    if(isInline())
+      return ConstIterator(0, *this);
+    return firstFrom(0);
   }
 
   const_iterator cend() const
   {
-    return ConstIterator(-1, -1, *this);
+    return ConstIterator(nullptr, -1, *this);
   }
 
   const_iterator begin() const
@@ -201,96 +456,175 @@ public:
   }
 
 private:
-  static const int NO_OF_BUCKETS = 16000;
-  std::array<SinglyLinkedList, NO_OF_BUCKETS> buckets;
+  using Node = typename SinglyLinkedList::Node;
+  using DataNode = typename SinglyLinkedList::DataNode;
+  using Inline = InlineEntries<value_type, InlineCapacity>;
+
+  static const size_type MIN_NO_OF_BUCKETS = 16;
+  std::vector<SinglyLinkedList> buckets; // always a power of two of them, so a bucket is picked by masking
   size_type size;
-  key_type smallestKey;
+  std::uint64_t seed; // random per map, so colliding keys cannot be precomputed by a client
 
 
-  key_type getSmallestKey() const
-  {
-    key_type smallestKey = 0;
-    bool wasAnyKeyFound = false;
-    if(isEmpty())
-      throw std::invalid_argument("empty map has no smallest element");
-    for(int i = 0; i < NO_OF_BUCKETS; i++)
-     if(!buckets[i].isEmpty()) {
-       for(auto bucketElement = buckets[i].begin(); bucketElement != buckets[i].end(); ++bucketElement) {
-        if(!wasAnyKeyFound) {
-          smallestKey = (*bucketElement).first;
-          wasAnyKeyFound = true;
-        } else if((*bucketElement).first < smallestKey)
-          smallestKey = (*bucketElement).first;
-       }
-     }
-    return smallestKey;
-  }
-
-  key_type getBiggestKey() const
-  {
-    key_type biggestKey = 0;
-    bool wasAnyKeyFound = false;
-    if(isEmpty())
-      throw std::invalid_argument("empty map has no smallest element");
-    for(int i = 0; i < NO_OF_BUCKETS; i++)
-     if(!buckets[i].isEmpty()) {
-       for(auto bucketElement = buckets[i].begin(); bucketElement != buckets[i].end(); ++bucketElement) {
-        if(!wasAnyKeyFound) {
-          biggestKey = (*bucketElement).first;
-          wasAnyKeyFound = true;
-        } else if((*bucketElement).first > biggestKey)
-          biggestKey = (*bucketElement).first;
-       }
-     }
-    return biggestKey;
-  }
-
-  key_type getNext(const key_type &key) const
+  // first element in buckets starting from the given one, end if there is none
+  const_iterator firstFrom(int bucket) const
   {
-    if(isEmpty())
-      throw std::invalid_argument("empty map has no elements");
+    for(int i = bucket; i < bucketCount(); i++)
+      if(!buckets[i].isEmpty())
+        return ConstIterator(buckets[i].head->next, i, *this);
+    return cend();
+  }
 
-    for(int i = getHash(key)+1; i < NO_OF_BUCKETS; i++) {
-    (void)i;
+  // last element in buckets up to the given one, end if there is none
+  const_iterator lastUpTo(int bucket) const
+  {
+    for(int i = bucket; i >= 0; i--)
       if(!buckets[i].isEmpty())
-        return (*buckets[i].begin()).first;
+        return ConstIterator(buckets[i].tail, i, *this);
+    return cend();
+  }
 
-    }
-    return key;
+  template <typename SearchedKey>
+  const_iterator search(const SearchedKey& key) const
+  {
+    if constexpr(InlineCapacity > 0)
+      if(isInline()) {
+        const size_type index = inlineIndexOf(key);
+        return index == size ? cend() : ConstIterator(static_cast<int>(index), *this);
+      }
+    const std::size_t hash = hashOf(key);
+    const int bucket = bucketOf(hash);
+    DataNode *node = buckets[bucket].findNode(key, hash, statistics());
+    if(node == nullptr)
+      return cend();
+    return ConstIterator(node, bucket, *this);
   }
 
-  key_type getPrevious(const key_type &key) const
+  template <typename SearchedKey>
+  const mapped_type* findValue(const SearchedKey& key) const
   {
-   if(isEmpty())
-      throw std::invalid_argument("empty map has no elements");
+    if constexpr(InlineCapacity > 0)
+      if(isInline()) {
+        const size_type index = inlineIndexOf(key);
+        return index == size ? nullptr : &this->inlineItem(index).second;
+      }
+    const std::size_t hash = hashOf(key);
+    const DataNode *node = buckets[bucketOf(hash)].findNode(key, hash, statistics());
+    return node == nullptr ? nullptr : &node->data.second;
+  }
 
-    for(int i = getHash(key)-1; i > 0; i--) {
-      if(!buckets[i].isEmpty())
-        return (*buckets[i].getLastElementIterator()).first;
+  // linear search of the inline entries, size when the key is not there
+  template <typename SearchedKey>
+  size_type inlineIndexOf(const SearchedKey& key) const
+  {
+    size_type index = 0;
+    while(index < size && !key_equal{}(this->inlineItem(index).first, key))
+      index++;
+    const size_type compared = index < size ? index + 1 : size;
+    Stats::lookup(compared, compared);
+    return index;
+  }
 
+  // moves the inline entries, all InlineCapacity of them, into a table big enough for one more
+  void spill()
+  {
+    size_type newBucketCount = MIN_NO_OF_BUCKETS;
+    while(newBucketCount < InlineCapacity + 1)
+      newBucketCount *= 2;
+    buckets = std::vector<SinglyLinkedList>(newBucketCount);
+    Stats::allocation(newBucketCount + 1);
+    for(size_type index = 0; index < size; index++) {
+      value_type& entry = this->inlineItem(index);
+      const std::size_t hash = hashOf(entry.first);
+      SinglyLinkedList& bucket = buckets[bucketOf(hash)];
+      if constexpr(Stats::enabled)
+        countAppend(bucket);
+      bucket.append(entry.first, hash, *this) = std::move(entry.second);
     }
-    return key;
+    this->clearInline();
   }
 
-  const_iterator search(const key_type& key) const
+  const Stats& statistics() const
   {
-    auto it = ConstIterator(key, *this);
-    try {
-      *it;
-    } catch(std::out_of_range e) {
-      return cend();
+    return *this;
+  }
+
+  // allocations of appending a node to bucket, and its conversion to a tree
+  void countAppend(const SinglyLinkedList& bucket) const
+  {
+    Stats::allocation(1);
+    if(bucket.isTreeified())
+      Stats::allocation(1); // the new node is moved into a TreeNode
+    else if(bucket.length + 1 > SinglyLinkedList::TREEIFY_THRESHOLD) {
+      Stats::rebalance();
+      Stats::allocation(bucket.length + 1);
     }
-    return it;
   }
 
-  int getHash(const key_type &key) const
+  // every treeified bucket has (or had) as many TreeNodes allocated as it has nodes
+  void countTreeifiedBuckets() const
+  {
+    for(const auto& bucket : buckets)
+      if(bucket.isTreeified()) {
+        Stats::rebalance();
+        Stats::allocation(bucket.length);
+      }
+  }
+
+  template <typename SearchedKey>
+  std::size_t hashOf(const SearchedKey &key) const
   {
-    return std::hash<key_type>{}(key) % NO_OF_BUCKETS;
+    return static_cast<std::size_t>(seededHash<hasher>(key, seed));
+  }
+
+  std::size_t hashOfNode(const DataNode &node) const
+  {
+    return hashOfNode(node, std::integral_constant<bool, CacheHash>());
+  }
+
+  std::size_t hashOfNode(const DataNode &node, std::true_type) const
+  {
+    return node.getHash();
+  }
+
+  std::size_t hashOfNode(const DataNode &node, std::false_type) const
+  {
+    return hashOf(node.data.first);
+  }
+
+  int bucketOf(std::size_t hash) const
+  {
+    return static_cast<int>(hash & (buckets.size() - 1));
+  }
+
+  int bucketCount() const
+  {
+    return static_cast<int>(buckets.size());
+  }
+
+  // moves all nodes to a table of newBucketCount buckets, cached hashes spare hashing the keys again
+  void rehash(size_type newBucketCount)
+  {
+    if constexpr(Stats::enabled) {
+      Stats::rebalance();
+      Stats::allocation(newBucketCount + 1);
+      countTreeifiedBuckets(); // untreeified by unlinkFirst()
+    }
+    std::vector<SinglyLinkedList> newBuckets(newBucketCount);
+    for(auto& bucket : buckets)
+      while(DataNode *node = bucket.unlinkFirst()) {
+        const std::size_t hash = hashOfNode(*node);
+        newBuckets[hash & (newBucketCount - 1)].linkNode(node, hash, *this);
+      }
+    buckets.swap(newBuckets);
+    if constexpr(Stats::enabled)
+      countTreeifiedBuckets();
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, bool CacheHash, typename Stats,
+          std::size_t InlineCapacity>
+class HashMap<KeyType, ValueType, Hash, KeyEqual, CacheHash, Stats, InlineCapacity>::ConstIterator
 {
 public:
   using reference = typename HashMap::const_reference;
@@ -300,36 +634,37 @@ public:
 
   friend class HashMap;
 private:
-  key_type currentKey;
-  int currentKeyBucket;
-  const HashMap& iteratorsHashMap;
+  Node *currentNode; // nullptr for end and inline entries
+  int currentBucket; // -1 for end
+  int inlineIndex; // position among inline entries, -1 for end and nodes
+  const HashMap *iteratorsHashMap;
 
 public:
-  explicit ConstIterator(key_type currentKey, int currentKeyBucket, const HashMap& iteratorsHashMap)
-   : currentKey(currentKey), currentKeyBucket(currentKeyBucket), iteratorsHashMap(iteratorsHashMap)
+  explicit ConstIterator()
+   : currentNode(nullptr), currentBucket(-1), inlineIndex(-1), iteratorsHashMap(nullptr)
   {}
-  explicit ConstIterator(key_type currentKey, const HashMap& iteratorsHashMap)
-   : currentKey(currentKey), currentKeyBucket(iteratorsHashMap.getHash(currentKey)), iteratorsHashMap(iteratorsHashMap)
+  explicit ConstIterator(Node *currentNode, int currentBucket, const HashMap& iteratorsHashMap)
+   : currentNode(currentNode), currentBucket(currentBucket), inlineIndex(-1), iteratorsHashMap(&iteratorsHashMap)
+  {}
+  explicit ConstIterator(int inlineIndex, const HashMap& iteratorsHashMap)
+   : currentNode(nullptr), currentBucket(-1), inlineIndex(inlineIndex), iteratorsHashMap(&iteratorsHashMap)
   {}
 
   ConstIterator& operator++()
   {
-    if(currentKeyBucket == -1)
+    if constexpr(InlineCapacity > 0)
+      if(inlineIndex >= 0) {
+        if(++inlineIndex == static_cast<int>(iteratorsHashMap->size))
+          inlineIndex = -1;
+        return *this;
+      }
+    if(currentNode == nullptr)
        throw std::out_of_range("cannot increment end");
 
-    auto it = iteratorsHashMap.buckets[currentKeyBucket].getIteratorForKey(currentKey);
-    if(++it != iteratorsHashMap.buckets[currentKeyBucket].end()) {
-      currentKey = (*it).first;
-      currentKeyBucket = iteratorsHashMap.getHash(currentKey);
-      return *this;
-    }
-    key_type previousKey = currentKey;
-    currentKey = iteratorsHashMap.getNext(currentKey);
-    if(currentKey == previousKey) { // no greater key found, so current element is the last one
-      currentKey = -1;
-      currentKeyBucket = -1;
-    } else
-      currentKeyBucket = iteratorsHashMap.getHash(currentKey);
+    if(currentNode->next != nullptr)
+      currentNode = currentNode->next;
+    else
+      *this = iteratorsHashMap->firstFrom(currentBucket + 1);
     return *this;
   }
 
@@ -342,29 +677,32 @@ public:
 
   ConstIterator& operator--()
   {
-    if(*this == iteratorsHashMap.begin())
-      throw std::out_of_range("cannot decrement begin, empty list");
-    if(currentKeyBucket == -1) {
-      key_type biggestKey = iteratorsHashMap.getBiggestKey();
-      this->currentKeyBucket = iteratorsHashMap.getHash(biggestKey);
-      this->currentKey = biggestKey;
+    if constexpr(InlineCapacity > 0)
+      if(iteratorsHashMap->isInline()) {
+        if(iteratorsHashMap->isEmpty())
+          throw std::out_of_range("cannot decrement begin, empty list");
+        if(inlineIndex == 0)
+          throw std::out_of_range("cannot decrement begin, nonempty list");
+        inlineIndex = inlineIndex < 0 ? static_cast<int>(iteratorsHashMap->size) - 1 : inlineIndex - 1;
+        return *this;
+      }
+    if(currentNode == nullptr) {
+      if(iteratorsHashMap->isEmpty())
+        throw std::out_of_range("cannot decrement begin, empty list");
+      *this = iteratorsHashMap->lastUpTo(iteratorsHashMap->bucketCount() - 1);
       return *this;
     }
 
-    auto it = iteratorsHashMap.buckets[currentKeyBucket].getIteratorForKey(currentKey);
-    if(it != iteratorsHashMap.buckets[currentKeyBucket].begin()) {
-      it = iteratorsHashMap.buckets[currentKeyBucket].getIteratorBefore(it);
-      currentKey = (*it).first;
-      currentKeyBucket = iteratorsHashMap.getHash(currentKey);
+    const SinglyLinkedList& bucket = iteratorsHashMap->buckets[currentBucket];
+    if(currentNode != bucket.head->next) {
+      currentNode = bucket.nodeBefore(currentNode);
       return *this;
     }
 
-    key_type previousKey = currentKey;
-    currentKey = iteratorsHashMap.getPrevious(currentKey);
-    if(currentKey == previousKey){ // no smaller key found, so current element is the first one
+    ConstIterator previous = iteratorsHashMap->lastUpTo(currentBucket - 1);
+    if(previous.currentNode == nullptr) // no earlier bucket has elements, so this is the first one
       throw std::out_of_range("cannot decrement begin, nonempty list");
-    } else
-      currentKeyBucket = iteratorsHashMap.getHash(currentKey);
+    *this = previous;
     return *this;
   }
 
@@ -377,9 +715,12 @@ public:
 
   reference operator*() const
   {
-    if(currentKeyBucket == -1)
+    if constexpr(InlineCapacity > 0)
+      if(inlineIndex >= 0)
+        return iteratorsHashMap->inlineItem(inlineIndex);
+    if(currentNode == nullptr)
       throw std::out_of_range("cannot dereference end");
-    return iteratorsHashMap.buckets[currentKeyBucket].getDataForKey(currentKey);
+    return static_cast<DataNode*>(currentNode)->data;
   }
 
   pointer operator->() const
@@ -389,10 +730,7 @@ public:
 
   bool operator==(const ConstIterator& other) const
   {
-    if(currentKeyBucket == -1 && currentKeyBucket == other.currentKeyBucket) // empty list
-      return true;
-
-    return currentKey == other.currentKey;
+    return currentNode == other.currentNode && inlineIndex == other.inlineIndex;
   }
 
   bool operator!=(const ConstIterator& other) const
@@ -401,8 +739,85 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::Iterator : public HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, bool CacheHash, typename Stats,
+          std::size_t InlineCapacity>
+class HashMap<KeyType, ValueType, Hash, KeyEqual, CacheHash, Stats, InlineCapacity>::LookupCursor
+{
+public:
+  explicit LookupCursor(const key_type& key, const HashMap& map)
+    : key(&key), map(&map), hash(map.hashOf(key)), bucket(map.bucketOf(hash)),
+      currentNode(nullptr), started(false), inTree(false)
+  {
+    if(!map.isInline())
+      prefetch(&map.buckets[bucket]);
+  }
+
+  // moves one node down the chain and prefetches it, returns true when the search is over
+  bool step()
+  {
+    using DataNode = typename SinglyLinkedList::DataNode;
+    using TreeNode = typename SinglyLinkedList::TreeNode;
+
+    if(map->isInline()) // entries are right in the map, nothing to wait for
+      return true;
+
+    if(!started) { // bucket is in cache, go to its sentinel or tree root
+      started = true;
+      const SinglyLinkedList& list = map->buckets[bucket];
+      inTree = list.isTreeified();
+      if(inTree)
+        currentNode = list.root;
+      else
+        currentNode = list.head;
+    } else if(inTree) {
+      const TreeNode *node = static_cast<TreeNode*>(currentNode);
+      if(node->hash == hash) {
+        if(key_equal{}(node->data.first, *key))
+          return true;
+        if constexpr(!SinglyLinkedList::IS_ORDERED) { // the key may be on either side, search both at once
+          currentNode = map->buckets[bucket].findInTree(*key, hash, map->statistics());
+          return true;
+        }
+      }
+      currentNode = SinglyLinkedList::goesLeft(*key, hash, node) ? node->left : node->right;
+      if(currentNode == nullptr)
+        return true;
+    } else {
+      if(currentNode != map->buckets[bucket].head
+         && static_cast<DataNode*>(currentNode)->mayMatch(hash)
+         && key_equal{}(static_cast<DataNode*>(currentNode)->data.first, *key))
+        return true;
+      currentNode = currentNode->next;
+      if(currentNode == nullptr)
+        return true;
+    }
+    prefetch(currentNode);
+    return false;
+  }
+
+  const_iterator position() const
+  {
+    if(map->isInline())
+      return map->search(*key);
+    if(currentNode == nullptr)
+      return map->cend();
+    return ConstIterator(currentNode, bucket, *map);
+  }
+
+private:
+  const key_type *key;
+  const HashMap *map;
+  std::size_t hash;
+  int bucket;
+  typename SinglyLinkedList::Node *currentNode;
+  bool started;
+  bool inTree;
+};
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, bool CacheHash, typename Stats,
+          std::size_t InlineCapacity>
+class HashMap<KeyType, ValueType, Hash, KeyEqual, CacheHash, Stats, InlineCapacity>::Iterator
+  : public HashMap<KeyType, ValueType, Hash, KeyEqual, CacheHash, Stats, InlineCapacity>::ConstIterator
 {
 public:
   using reference = typename HashMap::reference;
@@ -453,24 +868,45 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::SinglyLinkedList
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, bool CacheHash, typename Stats,
+          std::size_t InlineCapacity>
+class HashMap<KeyType, ValueType, Hash, KeyEqual, CacheHash, Stats, InlineCapacity>::SinglyLinkedList
 {
 public:
   class BucketIterator;
-
-  SinglyLinkedList() : head(new Node())
+  class Node;
+  class DataNode;
+  class TreeNode;
+
+  /*
+   * Chains longer than TREEIFY_THRESHOLD are additionally indexed by an AVL tree of their nodes,
+   * ordered by the full hash and, among equal hashes, by operator< of the keys when it agrees with
+   * KeyEqual (see OrdersLikeKeyEqual) - so even a bucket flooded with keys of one full hash is searched
+   * in O(log n). Without such an order equal hashes are told apart by KeyEqual alone, in both subtrees.
+   * The list order is kept, so iteration does not change. Chains shrinking to UNTREEIFY_THRESHOLD
+   * go back to plain nodes.
+   */
+  static const size_type TREEIFY_THRESHOLD = 8;
+  static const size_type UNTREEIFY_THRESHOLD = 6;
+  static const bool IS_ORDERED = OrdersLikeKeyEqual<key_type, key_equal>::value;
+
+  SinglyLinkedList() : head(new Node()), root(nullptr), length(0)
   {
     tail = head;
   }
 
   SinglyLinkedList(const SinglyLinkedList& other) : SinglyLinkedList()
   {
-    auto it = other.begin();
-    while(it != other.end())
-    {
-      append((*it).first) = (*it).second;
-      ++it;
+    for(Node *node = other.head->next; node != nullptr; node = node->next) {
+      length++;
+      if(other.root == nullptr) {
+        linkAtTail(new DataNode(*static_cast<DataNode*>(node)));
+        continue;
+      }
+      TreeNode *newNode = new TreeNode(*static_cast<TreeNode*>(node));
+      newNode->previous = tail;
+      linkAtTail(newNode);
+      root = insertIntoTree(root, newNode);
     }
   }
 
@@ -493,26 +929,70 @@ public:
     delete head;
   }
 
-  mapped_type& append(const key_type &key)
+  mapped_type& append(const key_type &key, std::size_t hash, const HashMap& map)
   {
     DataNode *newNode = new DataNode(key);
-    tail->next = newNode;
-    tail = newNode;
-    return newNode->data.second;
+    newNode->setHash(hash);
+    return linkNode(newNode, hash, map)->data.second;
+  }
+
+  /*
+   * Takes ownership of node, whose full hash is hash, and links it at the end; returns the node now holding its data.
+   * map hashes the other nodes when the chain is treeified.
+   */
+  DataNode* linkNode(DataNode *node, std::size_t hash, const HashMap& map)
+  {
+    node->next = nullptr;
+    if(root == nullptr && length + 1 > TREEIFY_THRESHOLD)
+      treeify(map);
+    length++;
+    if(root == nullptr) {
+      linkAtTail(node);
+      return node;
+    }
+    TreeNode *newNode = new TreeNode(std::move(*node), hash);
+    delete node;
+    newNode->previous = tail;
+    linkAtTail(newNode);
+    root = insertIntoTree(root, newNode);
+    return newNode;
   }
 
-  void remove(const key_type &key)
+  // detaches the first node and passes its ownership, nullptr when the list is empty
+  DataNode* unlinkFirst()
   {
+    if(root != nullptr)
+      untreeify();
+    DataNode *node = static_cast<DataNode*>(head->next);
+    if(node == nullptr)
+      return nullptr;
+    head->next = node->next;
+    if(head->next == nullptr)
+      tail = head;
+    length--;
+    return node;
+  }
+
+  void remove(const key_type &key, std::size_t hash, const Stats& stats)
+  {
+    if(root != nullptr) {
+      removeFromTreeifiedList(key, hash, stats);
+      return;
+    }
+
     bool wasFound = false;
+    std::size_t probes = 0, comparisons = 0;
     auto iteratorBeforeRemElem = begin(), iteratorToRemElem = begin();
     for( ; iteratorToRemElem != end(); ++iteratorToRemElem) {
-      if((*iteratorToRemElem).first == key) {
+      probes++;
+      if(matches(iteratorToRemElem.currentNode, key, hash, comparisons)) {
         wasFound = true;
         break;
       }
       iteratorBeforeRemElem = iteratorToRemElem;
     }
 
+    stats.lookup(probes, comparisons);
     if(!wasFound)
       throw std::out_of_range("cannot remove, element does not exist");
 
@@ -528,6 +1008,7 @@ public:
       iteratorBeforeRemElem.currentNode->next = iteratorToRemElem.currentNode->next;
 
     delete iteratorToRemElem.currentNode;
+    length--;
   }
 
   bool isEmpty() const
@@ -535,58 +1016,68 @@ public:
     return head->next == nullptr;
   }
 
-  value_type& getDataForKey(const key_type &key) const
+  bool isTreeified() const
   {
-    for(auto it = begin(); it != end(); ++it)
-      if((*it).first == key)
-        return *it;
-    throw std::out_of_range("element with given key does not exist");
+    return root != nullptr;
   }
 
-  bool isKeyPresent(const key_type &key) const
+  // nullptr when there is no such key
+  template <typename SearchedKey>
+  DataNode* findNode(const SearchedKey &key, std::size_t hash, const Stats& stats) const
   {
-    if(isEmpty())
-      return false;
-    for(auto it = begin(); it != end(); ++it)
-      if((*it).first == key)
-        return true;
-    return false;
+    if(root != nullptr)
+      return findInTree(key, hash, stats);
+    std::size_t probes = 0, comparisons = 0;
+    for(Node *node = head->next; node != nullptr; node = node->next) {
+      probes++;
+      if(matches(node, key, hash, comparisons)) {
+        stats.lookup(probes, comparisons);
+        return static_cast<DataNode*>(node);
+      }
+    }
+    stats.lookup(probes, comparisons);
+    return nullptr;
   }
 
-  void swap(SinglyLinkedList& first, SinglyLinkedList& second)
+  template <typename SearchedKey>
+  TreeNode* findInTree(const SearchedKey &key, std::size_t hash, const Stats& stats) const
   {
-    using std::swap;
-    swap(first.head, second.head);
-    swap(first.tail, second.tail);
+    std::size_t probes = 0, comparisons = 0;
+    TreeNode *node = findInSubtree(root, key, hash, probes, comparisons);
+    stats.lookup(probes, comparisons);
+    return node;
   }
 
-  BucketIterator getIteratorForKey(const key_type &key) const
+  // whether key of the given full hash is ordered before node
+  template <typename SearchedKey>
+  static bool goesLeft(const SearchedKey &key, std::size_t hash, const TreeNode *node)
   {
-    for(auto it = begin(); it != end(); ++it)
-      if((*it).first == key)
-        return it;
-    throw std::out_of_range("element with given key does not exist");
+    if(hash != node->hash)
+      return hash < node->hash;
+    if constexpr(IS_ORDERED)
+      return key < node->data.first;
+    else
+      return false;
   }
 
-  BucketIterator getIteratorBefore(BucketIterator &givenIt) const
+  void swap(SinglyLinkedList& first, SinglyLinkedList& second)
   {
-    auto prevIt = begin();
-    for(auto it = begin(); it != end(); ++it)
-    {
-      prevIt = it;
-      if(it == givenIt)
-        return prevIt;
-    }
-    return prevIt;
+    using std::swap;
+    swap(first.head, second.head);
+    swap(first.tail, second.tail);
+    swap(first.root, second.root);
+    swap(first.length, second.length);
   }
 
-  BucketIterator getLastElementIterator() const
+  // list predecessor of a data node, the sentinel for the first one
+  Node* nodeBefore(Node *node) const
   {
-    auto prevIt = begin();
-    for(auto it = begin(); it != end(); ++it)
-      prevIt = it;
-
-    return prevIt;
+    if(root != nullptr)
+      return static_cast<TreeNode*>(node)->previous;
+    Node *previous = head;
+    while(previous->next != node)
+      previous = previous->next;
+    return previous;
   }
 
   BucketIterator begin() const
@@ -607,15 +1098,33 @@ public:
     virtual ~Node() {}
   };
 
-  class DataNode : public Node
+  class DataNode : public Node, public CachedHash<CacheHash>
   {
   public:
     value_type data;
     DataNode(const key_type &key) : Node(), data({key, mapped_type{}}) {}
+    DataNode(const DataNode& other) : Node(), CachedHash<CacheHash>(other), data(other.data) {}
+    DataNode(DataNode&& other) : Node(), CachedHash<CacheHash>(other), data(std::move(other.data)) {}
+  };
+
+  class TreeNode : public DataNode
+  {
+  public:
+    TreeNode *left;
+    TreeNode *right;
+    Node *previous; // list predecessor, allows unlinking without walking the chain
+    int height;
+    std::size_t hash; // full hash of the key, kept even when DataNode does not cache it
+    TreeNode(DataNode&& other, std::size_t hash)
+      : DataNode(std::move(other)), left(nullptr), right(nullptr), previous(nullptr), height(1), hash(hash) {}
+    TreeNode(const TreeNode& other)
+      : DataNode(other), left(nullptr), right(nullptr), previous(nullptr), height(1), hash(other.hash) {}
   };
 
   Node *head;
   Node *tail;
+  TreeNode *root; // nullptr unless the chain is treeified
+  size_type length;
 
   class BucketIterator
   {
@@ -658,9 +1167,199 @@ public:
 
   };
 
+private:
+  void linkAtTail(Node *newNode)
+  {
+    tail->next = newNode;
+    tail = newNode;
+  }
+
+  // replaces every node of the chain with a TreeNode and builds the tree over them
+  void treeify(const HashMap& map)
+  {
+    Node *previous = head;
+    while(previous->next != nullptr) {
+      DataNode *oldNode = static_cast<DataNode*>(previous->next);
+      const std::size_t hash = map.hashOfNode(*oldNode);
+      TreeNode *newNode = new TreeNode(std::move(*oldNode), hash);
+      newNode->next = oldNode->next;
+      newNode->previous = previous;
+      previous->next = newNode;
+      root = insertIntoTree(root, newNode);
+      delete oldNode;
+      previous = newNode;
+    }
+    tail = previous;
+  }
+
+  void untreeify()
+  {
+    Node *previous = head;
+    while(previous->next != nullptr) {
+      TreeNode *oldNode = static_cast<TreeNode*>(previous->next);
+      DataNode *newNode = new DataNode(std::move(*oldNode));
+      newNode->next = oldNode->next;
+      previous->next = newNode;
+      delete oldNode;
+      previous = newNode;
+    }
+    tail = previous;
+    root = nullptr;
+  }
+
+  // comparisons is increased when the keys had to be compared
+  template <typename SearchedKey>
+  bool matches(const Node *node, const SearchedKey &key, std::size_t hash, std::size_t &comparisons) const
+  {
+    const DataNode *dataNode = static_cast<const DataNode*>(node);
+    if(!dataNode->mayMatch(hash))
+      return false;
+    comparisons++;
+    return key_equal{}(dataNode->data.first, key);
+  }
+
+  void removeFromTreeifiedList(const key_type &key, std::size_t hash, const Stats& stats)
+  {
+    TreeNode *node = findInTree(key, hash, stats);
+    if(node == nullptr)
+      throw std::out_of_range("cannot remove, element does not exist");
+
+    root = removeFromTree(root, node);
+    node->previous->next = node->next;
+    if(node->next != nullptr)
+      static_cast<TreeNode*>(node->next)->previous = node->previous;
+    else
+      tail = node->previous;
+    delete node;
+    length--;
+
+    if(length <= UNTREEIFY_THRESHOLD)
+      untreeify();
+  }
+
+  // the order of the tree, a total one: among equal hashes and unordered keys the addresses decide
+  static bool precedes(const TreeNode *first, const TreeNode *second)
+  {
+    if(first->hash != second->hash)
+      return first->hash < second->hash;
+    if constexpr(IS_ORDERED)
+      return first->data.first < second->data.first;
+    else
+      return std::less<const TreeNode*>{}(first, second);
+  }
 
+  template <typename SearchedKey>
+  static TreeNode* findInSubtree(TreeNode *node, const SearchedKey &key, std::size_t hash,
+                                 std::size_t &probes, std::size_t &comparisons)
+  {
+    while(node != nullptr) {
+      probes++;
+      if(node->hash == hash) {
+        comparisons++;
+        if(key_equal{}(node->data.first, key))
+          return node;
+        if constexpr(!IS_ORDERED) { // equal hashes lie on both sides
+          if(TreeNode *found = findInSubtree(node->left, key, hash, probes, comparisons))
+            return found;
+          node = node->right;
+          continue;
+        }
+      }
+      node = goesLeft(key, hash, node) ? node->left : node->right;
+    }
+    return nullptr;
+  }
 
+  static int heightOf(const TreeNode *node)
+  {
+    return node == nullptr ? 0 : node->height;
+  }
 
+  static void updateHeight(TreeNode *node)
+  {
+    node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+  }
+
+  static TreeNode* rotateRight(TreeNode *node)
+  {
+    TreeNode *newRoot = node->left;
+    node->left = newRoot->right;
+    newRoot->right = node;
+    updateHeight(node);
+    updateHeight(newRoot);
+    return newRoot;
+  }
+
+  static TreeNode* rotateLeft(TreeNode *node)
+  {
+    TreeNode *newRoot = node->right;
+    node->right = newRoot->left;
+    newRoot->left = node;
+    updateHeight(node);
+    updateHeight(newRoot);
+    return newRoot;
+  }
+
+  static TreeNode* rebalance(TreeNode *node)
+  {
+    updateHeight(node);
+    const int balance = heightOf(node->left) - heightOf(node->right);
+    if(balance > 1) {
+      if(heightOf(node->left->left) < heightOf(node->left->right))
+        node->left = rotateLeft(node->left);
+      return rotateRight(node);
+    }
+    if(balance < -1) {
+      if(heightOf(node->right->right) < heightOf(node->right->left))
+        node->right = rotateRight(node->right);
+      return rotateLeft(node);
+    }
+    return node;
+  }
+
+  // all helpers below return the new root of the given subtree
+  static TreeNode* insertIntoTree(TreeNode *subtree, TreeNode *node)
+  {
+    if(subtree == nullptr) {
+      node->left = node->right = nullptr;
+      node->height = 1;
+      return node;
+    }
+    if(precedes(node, subtree))
+      subtree->left = insertIntoTree(subtree->left, node);
+    else
+      subtree->right = insertIntoTree(subtree->right, node);
+    return rebalance(subtree);
+  }
+
+  static TreeNode* removeMinimum(TreeNode *subtree)
+  {
+    if(subtree->left == nullptr)
+      return subtree->right;
+    subtree->left = removeMinimum(subtree->left);
+    return rebalance(subtree);
+  }
+
+  static TreeNode* removeFromTree(TreeNode *subtree, TreeNode *node)
+  {
+    if(subtree == node) {
+      if(node->left == nullptr)
+        return node->right;
+      if(node->right == nullptr)
+        return node->left;
+      TreeNode *successor = node->right;
+      while(successor->left != nullptr)
+        successor = successor->left;
+      successor->right = removeMinimum(node->right);
+      successor->left = node->left;
+      return rebalance(successor);
+    }
+    if(precedes(node, subtree))
+      subtree->left = removeFromTree(subtree->left, node);
+    else
+      subtree->right = removeFromTree(subtree->right, node);
+    return rebalance(subtree);
+  }
 };
 
 }
@@ -0,0 +1,108 @@
+#ifndef AISDI_MAPS_INLINEENTRIES_H
+#define AISDI_MAPS_INLINEENTRIES_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace aisdi
+{
+
+/*
+ * Room for Capacity entries inside the object deriving from it - the first entries of a HashMap
+ * (see InlineCapacity of HashMap) or all entries of a small AdaptiveMap. Entries are constructed
+ * in place and kept packed at the front, a removed one replaced by the last.
+ */
+template <typename ValueType, std::size_t Capacity>
+class InlineEntries
+{
+public:
+  InlineEntries() : inlineCount(0)
+  {}
+
+  InlineEntries(const InlineEntries& other) : inlineCount(0)
+  {
+    for( ; inlineCount < other.inlineCount; inlineCount++)
+      new (inlineSlot(inlineCount)) ValueType(other.inlineItem(inlineCount));
+  }
+
+  InlineEntries& operator=(const InlineEntries&) = delete;
+
+  ~InlineEntries()
+  {
+    clearInline();
+  }
+
+protected:
+  std::size_t inlineCount;
+
+  ValueType& inlineItem(std::size_t index)
+  {
+    return *std::launder(reinterpret_cast<ValueType*>(storage) + index);
+  }
+
+  const ValueType& inlineItem(std::size_t index) const
+  {
+    return *std::launder(reinterpret_cast<const ValueType*>(storage) + index);
+  }
+
+  template <typename... Args>
+  ValueType& emplaceInline(Args&&... args)
+  {
+    ValueType *item = new (inlineSlot(inlineCount)) ValueType(std::forward<Args>(args)...);
+    inlineCount++;
+    return *item;
+  }
+
+  void removeInline(std::size_t index)
+  {
+    inlineItem(index).~ValueType();
+    if(index != inlineCount - 1) {
+      new (inlineSlot(index)) ValueType(std::move(inlineItem(inlineCount - 1)));
+      inlineItem(inlineCount - 1).~ValueType();
+    }
+    inlineCount--;
+  }
+
+  void clearInline()
+  {
+    for( ; inlineCount > 0; inlineCount--)
+      inlineItem(inlineCount - 1).~ValueType();
+  }
+
+  // entry by entry - keys are const, so the entries are moved through a temporary
+  void swapInline(InlineEntries& other)
+  {
+    InlineEntries& longer = inlineCount >= other.inlineCount ? *this : other;
+    InlineEntries& shorter = &longer == this ? other : *this;
+    std::size_t index = 0;
+    for( ; index < shorter.inlineCount; index++) {
+      ValueType temporary(std::move(longer.inlineItem(index)));
+      longer.inlineItem(index).~ValueType();
+      new (longer.inlineSlot(index)) ValueType(std::move(shorter.inlineItem(index)));
+      shorter.inlineItem(index).~ValueType();
+      new (shorter.inlineSlot(index)) ValueType(std::move(temporary));
+    }
+    for( ; index < longer.inlineCount; index++) {
+      new (shorter.inlineSlot(index)) ValueType(std::move(longer.inlineItem(index)));
+      longer.inlineItem(index).~ValueType();
+    }
+    std::swap(inlineCount, other.inlineCount);
+  }
+
+private:
+  alignas(ValueType) unsigned char storage[Capacity * sizeof(ValueType)];
+
+  void* inlineSlot(std::size_t index)
+  {
+    return storage + index * sizeof(ValueType);
+  }
+};
+
+template <typename ValueType>
+class InlineEntries<ValueType, 0>
+{};
+
+}
+
+#endif /* AISDI_MAPS_INLINEENTRIES_H */
@@ -0,0 +1,79 @@
+#ifndef AISDI_MAPS_INTERLEAVEDLOOKUP_H
+#define AISDI_MAPS_INTERLEAVEDLOOKUP_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+namespace aisdi
+{
+
+inline void prefetch(const void* address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address);
+#elif defined(_MSC_VER)
+  _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+  (void)address;
+#endif
+}
+
+/*
+ * Looks up keys[0..count) in map, keeping up to groupSize lookups in flight at once.
+ *
+ * Every map provides a LookupCursor (see startLookup()), a small state machine that moves
+ * one node further per step() and prefetches the node it is going to read next.
+ * Instead of waiting for that cache miss, the next cursor from the group is stepped,
+ * so the memory latency of one descent is hidden behind the work of the others.
+ *
+ * callback(index, position) is called once per key, in completion order (not in key order),
+ * with position == map.cend() for keys that are not present.
+ */
+template <typename Map, typename Callback>
+void interleavedFind(const Map& map, const typename Map::key_type* keys, std::size_t count,
+                     std::size_t groupSize, Callback callback)
+{
+  using Cursor = typename Map::LookupCursor;
+  if(groupSize == 0)
+    throw std::invalid_argument("group size must be positive");
+
+  std::vector<Cursor> group;
+  std::vector<std::size_t> indices;
+  group.reserve(groupSize);
+  indices.reserve(groupSize);
+
+  std::size_t next = 0;
+  for( ; next < count && group.size() < groupSize; next++) {
+    group.push_back(map.startLookup(keys[next]));
+    indices.push_back(next);
+  }
+
+  std::size_t active = group.size();
+  while(active > 0) {
+    for(std::size_t i = 0; i < active; ) {
+      if(!group[i].step()) {
+        i++;
+        continue;
+      }
+      callback(indices[i], group[i].position());
+      if(next < count) { // reuse the slot for the next key
+        group[i] = map.startLookup(keys[next]);
+        indices[i] = next++;
+        i++;
+      } else { // no keys left, shrink the group
+        active--;
+        group[i] = group[active];
+        indices[i] = indices[active];
+      }
+    }
+  }
+}
+
+}
+
+#endif /* AISDI_MAPS_INTERLEAVEDLOOKUP_H */
@@ -0,0 +1,174 @@
+#ifndef AISDI_MAPS_LATENCYHISTOGRAM_H
+#define AISDI_MAPS_LATENCYHISTOGRAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define AISDI_HAS_TSC
+#endif
+
+namespace aisdi
+{
+
+/*
+ * Cheap timestamps for timing single operations: the time stamp counter on x86
+ * (a few ns to read, against ~20 ns of clock_gettime), steady_clock elsewhere.
+ * Ticks are converted to nanoseconds with a rate calibrated against steady_clock once per process.
+ */
+class CycleClock
+{
+public:
+  static std::uint64_t now()
+  {
+#if defined(AISDI_HAS_TSC)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+  }
+
+  static double nanosecondsPerTick()
+  {
+    static const double rate = calibrate();
+    return rate;
+  }
+
+private:
+  static double calibrate()
+  {
+#if defined(AISDI_HAS_TSC)
+    const auto start = std::chrono::steady_clock::now();
+    const std::uint64_t startTicks = now();
+    std::chrono::steady_clock::time_point stop;
+    do
+      stop = std::chrono::steady_clock::now();
+    while(stop - start < std::chrono::milliseconds(20));
+    const std::uint64_t ticks = now() - startTicks;
+    return std::chrono::duration<double, std::nano>(stop - start).count() / ticks;
+#else
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::duration(1)).count();
+#endif
+  }
+};
+
+/*
+ * HDR-style log-linear histogram of non-negative integers (e.g. nanoseconds).
+ * Values below 2 * HALF are counted exactly, above that every power of two is split into HALF
+ * equal buckets - a relative error under 1 / HALF (~1.6%) over the whole 64-bit range,
+ * in a fixed array of ~3800 counters, so recording is a few instructions and never allocates.
+ */
+class LatencyHistogram
+{
+public:
+  LatencyHistogram() : counts(bucketIndex(UINT64_MAX) + 1, 0), total(0), maximum(0)
+  {}
+
+  void record(std::uint64_t value, std::uint64_t times = 1)
+  {
+    counts[bucketIndex(value)] += times;
+    total += times;
+    maximum = value > maximum ? value : maximum;
+  }
+
+  void merge(const LatencyHistogram& other)
+  {
+    for(std::size_t i = 0; i < counts.size(); i++)
+      counts[i] += other.counts[i];
+    total += other.total;
+    maximum = other.maximum > maximum ? other.maximum : maximum;
+  }
+
+  std::uint64_t count() const
+  {
+    return total;
+  }
+
+  std::uint64_t max() const
+  {
+    return maximum;
+  }
+
+  // smallest value v such that at least the given fraction of recorded values is <= v (up to bucket precision)
+  std::uint64_t percentile(double fraction) const
+  {
+    if(fraction < 0 || fraction > 1)
+      throw std::invalid_argument("percentile fraction must be within [0, 1]");
+    if(total == 0)
+      return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(fraction * total + 0.5);
+    rank = rank == 0 ? 1 : rank;
+    std::uint64_t seen = 0;
+    for(std::size_t i = 0; i < counts.size(); i++) {
+      seen += counts[i];
+      if(seen >= rank)
+        return upperBound(i) < maximum ? upperBound(i) : maximum;
+    }
+    return maximum;
+  }
+
+  // non-empty buckets, one "lower upper count" line each - stable text, to be diffed between runs
+  void dump(std::ostream& out) const
+  {
+    for(std::size_t i = 0; i < counts.size(); i++)
+      if(counts[i] != 0)
+        out << lowerBound(i) << "\t" << upperBound(i) << "\t" << counts[i] << "\n";
+  }
+
+private:
+  static const int SUB_BUCKET_BITS = 6;
+  static const std::uint64_t HALF = 1ull << SUB_BUCKET_BITS;
+
+  std::vector<std::uint64_t> counts;
+  std::uint64_t total;
+  std::uint64_t maximum;
+
+  static int highestBit(std::uint64_t value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while(value >>= 1)
+      bit++;
+    return bit;
+#endif
+  }
+
+  static std::size_t bucketIndex(std::uint64_t value)
+  {
+    if(value < 2 * HALF)
+      return static_cast<std::size_t>(value);
+    const int shift = highestBit(value) - SUB_BUCKET_BITS; // value >> shift is within [HALF, 2 * HALF)
+    return static_cast<std::size_t>(2 * HALF + (shift - 1) * HALF + ((value >> shift) - HALF));
+  }
+
+  static std::uint64_t lowerBound(std::size_t index)
+  {
+    if(index < 2 * HALF)
+      return index;
+    const int shift = static_cast<int>((index - 2 * HALF) / HALF) + 1;
+    return (HALF + (index - 2 * HALF) % HALF) << shift;
+  }
+
+  static std::uint64_t upperBound(std::size_t index)
+  {
+    if(index < 2 * HALF)
+      return index;
+    const int shift = static_cast<int>((index - 2 * HALF) / HALF) + 1;
+    return lowerBound(index) + ((1ull << shift) - 1);
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_LATENCYHISTOGRAM_H */
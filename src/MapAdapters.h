@@ -0,0 +1,220 @@
+#ifndef AISDI_MAPS_MAPADAPTERS_H
+#define AISDI_MAPS_MAPADAPTERS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace aisdi
+{
+
+/*
+ * Standard containers behind the interface of aisdi maps (operator[], valueOf(), tryGet(), find(), remove()),
+ * so that the benchmarks run exactly the same code against them. Misses are reported the aisdi way -
+ * valueOf() and remove() throw std::out_of_range.
+ */
+template <typename Container>
+class StdMapAdapter
+{
+public:
+  using key_type = typename Container::key_type;
+  using mapped_type = typename Container::mapped_type;
+  using value_type = typename Container::value_type;
+  using size_type = std::size_t;
+  using iterator = typename Container::iterator;
+  using const_iterator = typename Container::const_iterator;
+
+  bool isEmpty() const
+  {
+    return container.empty();
+  }
+
+  size_type getSize() const
+  {
+    return container.size();
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    return container[key];
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    return container.at(key);
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    return container.at(key);
+  }
+
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    const auto it = container.find(key);
+    return it == container.end() ? nullptr : &it->second;
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    const auto it = container.find(key);
+    return it == container.end() ? nullptr : &it->second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return container.find(key);
+  }
+
+  iterator find(const key_type& key)
+  {
+    return container.find(key);
+  }
+
+  void remove(const key_type& key)
+  {
+    if(container.erase(key) == 0)
+      throw std::out_of_range("cannot remove, element does not exist");
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it == container.end())
+      throw std::out_of_range("cannot erase end");
+    container.erase(it);
+  }
+
+  iterator begin() { return container.begin(); }
+  iterator end() { return container.end(); }
+  const_iterator begin() const { return container.begin(); }
+  const_iterator end() const { return container.end(); }
+  const_iterator cbegin() const { return container.cbegin(); }
+  const_iterator cend() const { return container.cend(); }
+
+private:
+  Container container;
+};
+
+template <typename KeyType, typename ValueType>
+using StdMap = StdMapAdapter<std::map<KeyType, ValueType>>;
+
+template <typename KeyType, typename ValueType>
+using StdUnorderedMap = StdMapAdapter<std::unordered_map<KeyType, ValueType>>;
+
+// Pairs kept sorted by key in one array: binary search lookups, but linear time inserts and removes.
+template <typename KeyType, typename ValueType>
+class SortedVectorMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<KeyType, ValueType>;
+  using size_type = std::size_t;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  bool isEmpty() const
+  {
+    return items.empty();
+  }
+
+  size_type getSize() const
+  {
+    return items.size();
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    auto it = lowerBound(key);
+    if(it == items.end() || key < it->first)
+      it = items.insert(it, value_type(key, mapped_type{}));
+    return it->second;
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    const mapped_type* value = tryGet(key);
+    if(value == nullptr)
+      throw std::out_of_range("key does not exist");
+    return *value;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    return const_cast<mapped_type&>(static_cast<const SortedVectorMap*>(this)->valueOf(key));
+  }
+
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    const auto it = find(key);
+    return it == items.end() ? nullptr : &it->second;
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const SortedVectorMap*>(this)->tryGet(key));
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    const auto it = lowerBound(key);
+    return it != items.end() && !(key < it->first) ? it : items.end();
+  }
+
+  iterator find(const key_type& key)
+  {
+    const auto it = lowerBound(key);
+    return it != items.end() && !(key < it->first) ? it : items.end();
+  }
+
+  void remove(const key_type& key)
+  {
+    const auto it = find(key);
+    if(it == items.end())
+      throw std::out_of_range("cannot remove, element does not exist");
+    items.erase(it);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it == items.end())
+      throw std::out_of_range("cannot erase end");
+    items.erase(it);
+  }
+
+  iterator begin() { return items.begin(); }
+  iterator end() { return items.end(); }
+  const_iterator begin() const { return items.begin(); }
+  const_iterator end() const { return items.end(); }
+  const_iterator cbegin() const { return items.cbegin(); }
+  const_iterator cend() const { return items.cend(); }
+
+private:
+  std::vector<value_type> items;
+
+  struct KeyLess
+  {
+    bool operator()(const value_type& item, const key_type& key) const
+    {
+      return item.first < key;
+    }
+  };
+
+  const_iterator lowerBound(const key_type& key) const
+  {
+    return std::lower_bound(items.begin(), items.end(), key, KeyLess());
+  }
+
+  iterator lowerBound(const key_type& key)
+  {
+    return std::lower_bound(items.begin(), items.end(), key, KeyLess());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_MAPADAPTERS_H */
@@ -0,0 +1,90 @@
+#ifndef AISDI_MAPS_MAPSTATS_H
+#define AISDI_MAPS_MAPSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "LatencyHistogram.h"
+
+namespace aisdi
+{
+
+/*
+ * What a map with CountingStats went through since it was constructed. A lookup is every search for a key:
+ * find(), tryGet(), valueOf(), operator[] and remove() - lookups through interleavedFind() are not counted.
+ *   probes      - nodes visited: chain nodes of a hash bucket (or nodes of its tree), tree nodes on the way down,
+ *   comparisons - key comparisons made (a cached hash that differs spares one),
+ *   allocations - nodes, sentinels and bucket arrays allocated,
+ *   rebalances  - HashMap: table growths and conversions of buckets to trees and back, TreeMap: none (not balanced).
+ */
+struct MapStats
+{
+  std::uint64_t lookups = 0;
+  std::uint64_t probes = 0;
+  std::uint64_t comparisons = 0;
+  std::uint64_t allocations = 0;
+  std::uint64_t rebalances = 0;
+  LatencyHistogram probesPerLookup; // chain walk length of HashMap, descent depth of TreeMap
+  LatencyHistogram comparisonsPerLookup;
+};
+
+/*
+ * Statistics policies of HashMap and TreeMap. The maps derive from the policy privately and call
+ * its hooks (const, so that const lookups are counted too) with counts kept in locals,
+ * so with the empty NoStats the hooks, the counting and the member itself compile away.
+ */
+struct NoStats
+{
+  static const bool enabled = false;
+
+  void lookup(std::size_t, std::size_t) const
+  {}
+
+  void allocation(std::size_t = 1) const
+  {}
+
+  void rebalance() const
+  {}
+
+  MapStats snapshot() const
+  {
+    return MapStats();
+  }
+};
+
+class CountingStats
+{
+public:
+  static const bool enabled = true;
+
+  void lookup(std::size_t probes, std::size_t comparisons) const
+  {
+    current.lookups++;
+    current.probes += probes;
+    current.comparisons += comparisons;
+    current.probesPerLookup.record(probes);
+    current.comparisonsPerLookup.record(comparisons);
+  }
+
+  void allocation(std::size_t count = 1) const
+  {
+    current.allocations += count;
+  }
+
+  void rebalance() const
+  {
+    current.rebalances++;
+  }
+
+  MapStats snapshot() const
+  {
+    return current;
+  }
+
+private:
+  mutable MapStats current;
+};
+
+}
+
+#endif /* AISDI_MAPS_MAPSTATS_H */
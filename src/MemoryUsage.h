@@ -0,0 +1,45 @@
+#ifndef AISDI_MAPS_MEMORYUSAGE_H
+#define AISDI_MAPS_MEMORYUSAGE_H
+
+#include <cstddef>
+
+namespace aisdi
+{
+
+// Footprint of a chunk handed out by a glibc-like malloc for the given request:
+// a size_t header, alignment to two size_t and a minimum of four size_t.
+inline std::size_t mallocChunkBytes(std::size_t requested)
+{
+  const std::size_t header = sizeof(std::size_t), alignment = 2 * sizeof(std::size_t);
+  const std::size_t chunk = (requested + header + alignment - 1) / alignment * alignment;
+  return chunk < 4 * sizeof(std::size_t) ? 4 * sizeof(std::size_t) : chunk;
+}
+
+/*
+ * Heap memory owned by a map - nodes, sentinels, bucket arrays - as returned by memoryUsage().
+ * Memory owned by the keys and values themselves (e.g. long strings) is not included,
+ * neither is the map object itself.
+ */
+struct MemoryUsage
+{
+  std::size_t allocations = 0;    // live heap blocks
+  std::size_t requestedBytes = 0; // as asked from operator new, vtable pointers and padding included
+  std::size_t heapBytes = 0;      // requested bytes rounded up to malloc chunks, see mallocChunkBytes()
+  std::size_t payloadBytes = 0;   // what the entries need: size * sizeof(value_type)
+
+  void addBlocks(std::size_t count, std::size_t bytesEach)
+  {
+    allocations += count;
+    requestedBytes += count * bytesEach;
+    heapBytes += count * mallocChunkBytes(bytesEach);
+  }
+
+  std::size_t overheadBytes() const
+  {
+    return heapBytes - payloadBytes;
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_MEMORYUSAGE_H */
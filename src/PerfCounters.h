@@ -0,0 +1,146 @@
+#ifndef AISDI_MAPS_PERFCOUNTERS_H
+#define AISDI_MAPS_PERFCOUNTERS_H
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace aisdi
+{
+
+/*
+ * Hardware counters of the calling thread (user space only) read through Linux perf_event_open:
+ * cycles, instructions, branch misses, L1 data, last level cache and data TLB read misses.
+ *
+ * Every counter is opened separately, so whatever the kernel, the CPU or the container allows is counted
+ * and the rest reads as NaN. Counters multiplexed by the kernel are scaled by their enabled / running time.
+ * Elsewhere than on Linux nothing is available.
+ */
+class PerfCounters
+{
+public:
+  PerfCounters()
+  {
+#if defined(__linux__)
+    const std::uint64_t readMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    addEvent("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    addEvent("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    addEvent("branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    addEvent("L1d-misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | readMiss);
+    addEvent("LLC-misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | readMiss);
+    addEvent("dTLB-misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | readMiss);
+#else
+    failure = "hardware counters are only supported on Linux";
+#endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  ~PerfCounters()
+  {
+#if defined(__linux__)
+    for(const auto& event : events)
+      if(event.fd >= 0)
+        close(event.fd);
+#endif
+  }
+
+  // true when at least one counter could be opened
+  bool isAvailable() const
+  {
+    for(const auto& event : events)
+      if(event.fd >= 0)
+        return true;
+    return false;
+  }
+
+  // why the first counter that failed could not be opened, empty when all are counted
+  const std::string& unavailableReason() const
+  {
+    return failure;
+  }
+
+  std::vector<std::string> names() const
+  {
+    std::vector<std::string> result;
+    for(const auto& event : events)
+      result.push_back(event.name);
+    return result;
+  }
+
+  void start()
+  {
+#if defined(__linux__)
+    for(const auto& event : events)
+      if(event.fd >= 0) {
+        ioctl(event.fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(event.fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+  }
+
+  // counts since start(), in the order of names(), NaN for counters that are not available
+  std::vector<double> stop()
+  {
+    std::vector<double> values(events.size(), std::numeric_limits<double>::quiet_NaN());
+#if defined(__linux__)
+    for(const auto& event : events)
+      if(event.fd >= 0)
+        ioctl(event.fd, PERF_EVENT_IOC_DISABLE, 0);
+    for(std::size_t i = 0; i < events.size(); i++) {
+      std::uint64_t reading[3]; // value, time enabled, time running
+      if(events[i].fd < 0 || read(events[i].fd, reading, sizeof(reading)) != sizeof(reading) || reading[2] == 0)
+        continue;
+      values[i] = static_cast<double>(reading[0]) * reading[1] / reading[2];
+    }
+#endif
+    return values;
+  }
+
+private:
+  struct Event
+  {
+    std::string name;
+    int fd;
+  };
+
+  std::vector<Event> events;
+  std::string failure;
+
+#if defined(__linux__)
+  void addEvent(const char* name, std::uint32_t type, std::uint64_t config)
+  {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1; // allowed with the default perf_event_paranoid of 2
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    const int fd = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+    if(fd < 0 && failure.empty())
+      failure = std::string(name) + ": " + std::strerror(errno)
+        + " (no PMU access in this container or VM? see /proc/sys/kernel/perf_event_paranoid)";
+    events.push_back({ name, fd });
+  }
+#endif
+};
+
+}
+
+#endif /* AISDI_MAPS_PERFCOUNTERS_H */
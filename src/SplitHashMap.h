@@ -0,0 +1,384 @@
+#ifndef AISDI_MAPS_SPLITHASHMAP_H
+#define AISDI_MAPS_SPLITHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ArrayView.h"
+#include "ArrowProxy.h"
+#include "FlatHashMap.h"
+#include "Hash.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+/*
+ * Keys and values kept in two separate vectors without holes (struct of arrays), found through
+ * a FlatHashMap from key to position - for maps scanned far more often than searched:
+ * values() is one contiguous array, so summing or filtering the values reads nothing else and
+ * vectorizes, where iterating any map of pairs drags every key through the cache along with its value.
+ * Lookups probe the index only and read the value array once, keys() serves scans of keys alone.
+ *
+ * The index keeps a second copy of every key (cheap for numbers, not for long strings). Removal
+ * moves the last entry into the freed position, so iteration order is insertion order only until
+ * the first removal. As in FlatMap, iterators dereference to a pair of references; they and the
+ * views are invalidated by every insertion and removal.
+ */
+template <typename KeyType, typename ValueType,
+          typename Hash = aisdi::Hash<KeyType>, typename KeyEqual = aisdi::EqualTo<KeyType>,
+          typename Group = DefaultGroup>
+class SplitHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = std::pair<const key_type&, mapped_type&>;
+  using const_reference = std::pair<const key_type&, const mapped_type&>;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  SplitHashMap()
+  {}
+
+  SplitHashMap(std::initializer_list<value_type> list)
+  {
+    for(auto element : list)
+      operator[](element.first) = element.second;
+  }
+
+  bool isEmpty() const
+  {
+    return keyArray.empty();
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    const std::uint32_t *found = positions.tryGet(key);
+    if(found != nullptr)
+      return valueArray[*found];
+    if(keyArray.size() == std::numeric_limits<std::uint32_t>::max())
+      throw std::length_error("cannot add, too many elements");
+    // the index first - if an array throws then, the key is taken out again and all three stay in step
+    positions[key] = static_cast<std::uint32_t>(keyArray.size());
+    try {
+      keyArray.push_back(key);
+      valueArray.push_back(mapped_type{});
+    } catch(...) {
+      if(keyArray.size() > valueArray.size())
+        keyArray.pop_back();
+      positions.remove(key);
+      throw;
+    }
+    return valueArray.back();
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    if(isEmpty())
+      throw std::out_of_range("empty map, cannot get value");
+    const mapped_type *value = tryGet(key);
+    if(value == nullptr)
+      throw std::out_of_range("element with given key does not exist");
+    return *value;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<mapped_type&>(static_cast<const SplitHashMap*>(this)->valueOf(key));
+  }
+
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    const std::uint32_t *found = positions.tryGet(key);
+    return found == nullptr ? nullptr : &valueArray[*found];
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const SplitHashMap*>(this)->tryGet(key));
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    const std::uint32_t *found = positions.tryGet(key);
+    return ConstIterator(found == nullptr ? keyArray.size() : *found, *this);
+  }
+
+  iterator find(const key_type& key)
+  {
+    return static_cast<const SplitHashMap*>(this)->find(key);
+  }
+
+  void remove(const key_type& key)
+  {
+    if(isEmpty())
+      throw std::out_of_range("cannot remove, empty list");
+    const std::uint32_t *found = positions.tryGet(key);
+    if(found == nullptr)
+      throw std::out_of_range("cannot remove, element does not exist");
+    erase(*found);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it == cend())
+      throw std::out_of_range("cannot remove end");
+    erase(it.position);
+  }
+
+  size_type getSize() const
+  {
+    return keyArray.size();
+  }
+
+  // all keys, in the order of values()
+  ArrayView<const key_type> keys() const
+  {
+    return ArrayView<const key_type>(keyArray.data(), keyArray.size());
+  }
+
+  // all values, in the order of keys()
+  ArrayView<const mapped_type> values() const
+  {
+    return ArrayView<const mapped_type>(valueArray.data(), valueArray.size());
+  }
+
+  ArrayView<mapped_type> values()
+  {
+    return ArrayView<mapped_type>(valueArray.data(), valueArray.size());
+  }
+
+  // callback(keys(), values()) once - the same interface as FlatMap, both arrays are already contiguous
+  template <typename Callback>
+  void forEachChunk(Callback callback) const
+  {
+    if(!isEmpty())
+      callback(keys(), values());
+  }
+
+  // the index and the two arrays
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage = positions.memoryUsage();
+    if(keyArray.capacity() != 0)
+      usage.addBlocks(1, keyArray.capacity() * sizeof(key_type));
+    if(valueArray.capacity() != 0)
+      usage.addBlocks(1, valueArray.capacity() * sizeof(mapped_type));
+    usage.payloadBytes = keyArray.size() * sizeof(value_type);
+    return usage;
+  }
+
+  bool operator==(const SplitHashMap& other) const
+  {
+    if(getSize() != other.getSize())
+      return false;
+    for(size_type position = 0; position < other.keyArray.size(); position++) {
+      const mapped_type *value = tryGet(other.keyArray[position]);
+      if(value == nullptr || !(*value == other.valueArray[position]))
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const SplitHashMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return cbegin();
+  }
+
+  iterator end()
+  {
+    return cend();
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(0, *this);
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(keyArray.size(), *this);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  FlatHashMap<key_type, std::uint32_t, Hash, KeyEqual, Group> positions; // key -> position in both arrays
+  std::vector<key_type> keyArray;
+  std::vector<mapped_type> valueArray;
+
+  // the last entry takes the place of the removed one
+  void erase(size_type position)
+  {
+    positions.remove(keyArray[position]);
+    const size_type last = keyArray.size() - 1;
+    if(position != last) {
+      keyArray[position] = std::move(keyArray[last]);
+      valueArray[position] = std::move(valueArray[last]);
+      *positions.tryGet(keyArray[position]) = static_cast<std::uint32_t>(position);
+    }
+    keyArray.pop_back();
+    valueArray.pop_back();
+  }
+};
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Group>
+class SplitHashMap<KeyType, ValueType, Hash, KeyEqual, Group>::ConstIterator
+{
+public:
+  using reference = typename SplitHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename SplitHashMap::value_type;
+  using difference_type = std::ptrdiff_t;
+
+  using pointer = ArrowProxy<reference>;
+
+  friend class SplitHashMap;
+
+  explicit ConstIterator() : position(0), map(nullptr)
+  {}
+
+  explicit ConstIterator(size_type position, const SplitHashMap& map) : position(position), map(&map)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(position >= map->keyArray.size())
+      throw std::out_of_range("cannot increment end");
+    position++;
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator old(*this);
+    operator++();
+    return old;
+  }
+
+  ConstIterator& operator--()
+  {
+    if(position == 0)
+      throw std::out_of_range(map->isEmpty() ? "cannot decrement begin, empty map" : "cannot decrement begin");
+    position--;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator old(*this);
+    operator--();
+    return old;
+  }
+
+  reference operator*() const
+  {
+    if(position >= map->keyArray.size())
+      throw std::out_of_range("cannot dereference end");
+    return reference(map->keyArray[position], map->valueArray[position]);
+  }
+
+  pointer operator->() const
+  {
+    return pointer(operator*());
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return position == other.position && map == other.map;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+
+protected:
+  size_type position; // keyArray.size() for end
+  const SplitHashMap *map;
+};
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Group>
+class SplitHashMap<KeyType, ValueType, Hash, KeyEqual, Group>::Iterator
+  : public SplitHashMap<KeyType, ValueType, Hash, KeyEqual, Group>::ConstIterator
+{
+public:
+  using reference = typename SplitHashMap::reference;
+  using pointer = ArrowProxy<reference>;
+
+  explicit Iterator()
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return pointer(operator*());
+  }
+
+  reference operator*() const
+  {
+    const auto item = ConstIterator::operator*();
+    // ugly cast, yet reduces code duplication.
+    return reference(item.first, const_cast<mapped_type&>(item.second));
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_SPLITHASHMAP_H */
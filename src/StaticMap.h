@@ -0,0 +1,156 @@
+#ifndef AISDI_MAPS_STATICMAP_H
+#define AISDI_MAPS_STATICMAP_H
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+namespace aisdi
+{
+
+/*
+ * A lookup table fixed at compile time - opcodes, protocol field ids - built by makeStaticMap():
+ *
+ *   constexpr auto opcodes = aisdi::makeStaticMap<std::string_view, int>({ { "add", 1 }, { "sub", 2 } });
+ *
+ * The entries are sorted by the compiler and stored in the binary, so a constexpr map costs nothing
+ * at startup (unlike a HashMap filled from an initializer_list) and lookups can be evaluated at compile time.
+ * Lookup is the branchless binary search of FlatMap over at most a few cache lines for typical tables.
+ * A repeated key is a compile error (std::invalid_argument thrown during constant evaluation).
+ *
+ * Keys need a constexpr operator< - integers, enums, std::string_view. Everything is const,
+ * so value_type is a plain pair and iterators are pointers to the sorted entries.
+ */
+template <typename KeyType, typename ValueType, std::size_t N>
+class StaticMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using const_iterator = const value_type*;
+  using iterator = const_iterator;
+
+  constexpr explicit StaticMap(const value_type (&items)[N])
+    : StaticMap(items, sortedOrder(items), std::make_index_sequence<N>())
+  {}
+
+  // for tables computed by a constexpr function
+  constexpr explicit StaticMap(const std::array<value_type, N>& items)
+    : StaticMap(items, sortedOrder(items), std::make_index_sequence<N>())
+  {}
+
+  constexpr bool isEmpty() const
+  {
+    return N == 0;
+  }
+
+  constexpr size_type getSize() const
+  {
+    return N;
+  }
+
+  constexpr const mapped_type& valueOf(const key_type& key) const
+  {
+    if(isEmpty())
+      throw std::out_of_range("empty map, cannot get value");
+    const_iterator position = find(key);
+    if(position == end())
+      throw std::out_of_range("element with given key does not exist");
+    return position->second;
+  }
+
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  constexpr const mapped_type* tryGet(const key_type& key) const
+  {
+    const_iterator position = find(key);
+    return position == end() ? nullptr : &position->second;
+  }
+
+  constexpr const_iterator find(const key_type& key) const
+  {
+    const size_type position = lowerBound(key);
+    if(position == N || key < entries[position].first)
+      return end();
+    return begin() + position;
+  }
+
+  constexpr const_iterator begin() const
+  {
+    return entries.data();
+  }
+
+  constexpr const_iterator end() const
+  {
+    return entries.data() + N;
+  }
+
+  constexpr const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  constexpr const_iterator cend() const
+  {
+    return end();
+  }
+
+private:
+  std::array<value_type, N> entries; // sorted by key
+
+  // pair has no constexpr assignment before C++20, so the entries are copied in sorted order instead of sorted
+  template <typename Items, std::size_t... Index>
+  constexpr StaticMap(const Items& items, const std::array<size_type, N>& order, std::index_sequence<Index...>)
+    : entries{ { items[order[Index]]... } }
+  {}
+
+  // insertion sort of the positions of items by key - tables are small and this runs in the compiler
+  template <typename Items>
+  static constexpr std::array<size_type, N> sortedOrder(const Items& items)
+  {
+    std::array<size_type, N> order{};
+    for(size_type i = 0; i < N; i++) {
+      size_type j = i;
+      for( ; j > 0 && items[i].first < items[order[j - 1]].first; j--)
+        order[j] = order[j - 1];
+      order[j] = i;
+    }
+    for(size_type i = 1; i < N; i++)
+      if(!(items[order[i - 1]].first < items[order[i]].first))
+        throw std::invalid_argument("cannot build StaticMap, repeated key");
+    return order;
+  }
+
+  // as in FlatMap - the range halves on every step, the comparison becomes a conditional move
+  constexpr size_type lowerBound(const key_type& key) const
+  {
+    if(N == 0)
+      return 0;
+    size_type base = 0, length = N;
+    while(length > 1) {
+      const size_type half = length / 2;
+      base = entries[base + half].first < key ? base + half : base;
+      length -= half;
+    }
+    return base + (entries[base].first < key);
+  }
+};
+
+// makeStaticMap<K, V>({ { key, value }, ... }) - the number of entries is deduced
+template <typename KeyType, typename ValueType, std::size_t N>
+constexpr StaticMap<KeyType, ValueType, N> makeStaticMap(const std::pair<KeyType, ValueType> (&items)[N])
+{
+  return StaticMap<KeyType, ValueType, N>(items);
+}
+
+template <typename KeyType, typename ValueType, std::size_t N>
+constexpr StaticMap<KeyType, ValueType, N> makeStaticMap(const std::array<std::pair<KeyType, ValueType>, N>& items)
+{
+  return StaticMap<KeyType, ValueType, N>(items);
+}
+
+}
+
+#endif /* AISDI_MAPS_STATICMAP_H */
@@ -1,16 +1,35 @@
 #ifndef AISDI_MAPS_TREEMAP_H
 #define AISDI_MAPS_TREEMAP_H
 
+#include <algorithm>
 #include <cstddef>
 #include <initializer_list>
+#include <map>
 #include <stdexcept>
 #include <utility>
+#include <vector>
+
+#include "ArrayView.h"
+#include "InterleavedLookup.h"
+#include "MapStats.h"
+#include "MemoryUsage.h"
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
-class TreeMap
+// Shape of a TreeMap, see TreeMap::shapeReport(). Depths count nodes, the root is at depth 1.
+struct TreeShape
+{
+  std::size_t size = 0;
+  std::size_t height = 0;        // depth of the deepest node, 0 for an empty tree
+  std::size_t minimalHeight = 0; // height of a complete tree of the same size
+  double averageDepth = 0;       // nodes visited by an average successful search
+  std::map<int, std::size_t> balanceFactors; // height of left minus right subtree -> number of such nodes
+};
+
+// Stats is NoStats or CountingStats, see MapStats.h.
+template <typename KeyType, typename ValueType, typename Stats = NoStats>
+class TreeMap : private Stats
 {
 public:
   using key_type = KeyType;
@@ -22,9 +41,12 @@ public:
 
   class ConstIterator;
   class Iterator;
+  class LookupCursor;
   using iterator = Iterator;
   using const_iterator = ConstIterator;
 
+  static const size_type CHUNK_SIZE = 64; // entries per batch of forEachChunk()
+
   TreeMap()
   {
     setup();
@@ -40,10 +62,20 @@ public:
   TreeMap(const TreeMap& other)
   {
     setup();
-    for(auto element : other)
-    {
-      operator[](element.first) = element.second;
+    if(other.isEmpty())
+      return;
+    // clone the shape - inserting the elements in (sorted) iteration order would degenerate the tree into a list
+    head->right = nullptr;
+    try {
+      copyTree(other.head->left);
+    } catch(...) {
+      if(head->left != head)
+        freeSubtree(head->left);
+      delete head;
+      throw;
     }
+    size = other.size;
+    Stats::allocation(size);
   }
 
   TreeMap(TreeMap&& other) : TreeMap()
@@ -62,7 +94,7 @@ public:
   ~TreeMap()
   {
     if(!isEmpty())
-      postOrderTraversalFreeingMemory(head->left);
+      freeSubtree(head->left);
     delete head;
   }
 
@@ -79,12 +111,17 @@ public:
         head->left = newNode; // list no longer empty
         head->right = nullptr; // important for check against decrementing begin() in empty map
         size++;
+        Stats::lookup(0, 0);
+        Stats::allocation();
         return newNode->data.second;
     }
+    std::size_t depth = 0;
     BinaryNode *next = head->left, *current = nullptr;
     while(next != nullptr) {
         current = next;
+        depth++;
         if(key == current->data.first) { //node with this key already exists
+            Stats::lookup(depth, 2 * depth - 1);
             return current->data.second;
         }
         if(key < current->data.first)
@@ -92,6 +129,8 @@ public:
         else
             next = current->right;
     }
+    Stats::lookup(depth, 2 * depth);
+    Stats::allocation();
 
     BinaryNode *newNode = new BinaryNode(key);
     newNode->parent = current;
@@ -123,6 +162,22 @@ public:
     return position->second;
   }
 
+  // nullptr for a missing key - unlike valueOf() a miss costs no exception
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    if(isEmpty())
+      return nullptr;
+    const_iterator position = search(head->left, key);
+    if(position == cend())
+      return nullptr;
+    return &position->second;
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    return const_cast<mapped_type*>(static_cast<const TreeMap*>(this)->tryGet(key));
+  }
+
   const_iterator find(const key_type& key) const
   {
     if(isEmpty())
@@ -137,6 +192,12 @@ public:
     return search(head->left, key);
   }
 
+  // key has to outlive the cursor, see interleavedFind() in InterleavedLookup.h
+  LookupCursor startLookup(const key_type& key) const
+  {
+    return LookupCursor(isEmpty() ? nullptr : head->left, key, *this);
+  }
+
   void remove(const key_type& key)
   {
     if(isEmpty())
@@ -181,6 +242,90 @@ public:
     return size;
   }
 
+  /*
+   * Hands all entries to callback(ArrayView<const value_type* const>) in batches of up to CHUNK_SIZE,
+   * in key order - gathered by one in-order walk along the parent links, without the checks of ConstIterator,
+   * so the consumer loops over a plain array. Entries live in separate nodes, hence pointers.
+   */
+  template <typename Callback>
+  void forEachChunk(Callback callback) const
+  {
+    const value_type *chunk[CHUNK_SIZE];
+    size_type count = 0;
+    for(const BinaryNode *node = firstNode(); node != head; node = successor(node)) {
+      chunk[count++] = &node->data;
+      if(count == CHUNK_SIZE) {
+        callback(ArrayView<const value_type* const>(chunk, count));
+        count = 0;
+      }
+    }
+    if(count != 0)
+      callback(ArrayView<const value_type* const>(chunk, count));
+  }
+
+  // heap memory of the nodes, the sentinel head included
+  MemoryUsage memoryUsage() const
+  {
+    MemoryUsage usage;
+    usage.addBlocks(size + 1, sizeof(BinaryNode));
+    usage.payloadBytes = size * sizeof(value_type);
+    return usage;
+  }
+
+  // counted since construction, all zero unless Stats is CountingStats
+  MapStats stats() const
+  {
+    return Stats::snapshot();
+  }
+
+  /*
+   * One post-order pass over the nodes, O(n) time and O(height) memory - iterative, so that a tree
+   * degenerated into a list (height equal to size, e.g. after inserting sorted keys) does not overflow the stack.
+   */
+  TreeShape shapeReport() const
+  {
+    TreeShape shape;
+    shape.size = size;
+    for(size_type nodes = size; nodes != 0; nodes /= 2)
+      shape.minimalHeight++;
+    if(isEmpty())
+      return shape;
+
+    struct Frame
+    {
+      const BinaryNode *node;
+      std::size_t depth;
+      std::size_t leftHeight;
+      int stage; // 0 - left subtree to visit, 1 - right subtree to visit, 2 - both visited
+    };
+    std::vector<Frame> stack = { { head->left, 1, 0, 0 } };
+    std::size_t depthSum = 0, finishedHeight = 0; // height of the subtree visited last
+    while(!stack.empty()) {
+      Frame& frame = stack.back();
+      const BinaryNode *child = nullptr;
+      if(frame.stage == 0)
+        child = frame.node->left;
+      else if(frame.stage == 1) {
+        frame.leftHeight = finishedHeight;
+        child = frame.node->right;
+      } else {
+        const std::size_t rightHeight = finishedHeight;
+        finishedHeight = 1 + std::max(frame.leftHeight, rightHeight);
+        shape.height = std::max(shape.height, frame.depth);
+        depthSum += frame.depth;
+        shape.balanceFactors[static_cast<int>(frame.leftHeight) - static_cast<int>(rightHeight)]++;
+        stack.pop_back();
+        continue;
+      }
+      frame.stage++;
+      finishedHeight = 0; // of a missing child
+      if(child != nullptr)
+        stack.push_back({ child, frame.depth + 1, 0, 0 });
+    }
+    shape.averageDepth = double(depthSum) / size;
+    return shape;
+  }
+
   bool operator==(const TreeMap& other) const
   {
     if(size != other.size)
@@ -246,6 +391,7 @@ private:
     value_type data;
     BinaryNode() {}
     BinaryNode(const key_type& key) : left(nullptr), right(nullptr), data(std::make_pair(key, mapped_type{})) {}
+    BinaryNode(const value_type& data) : left(nullptr), right(nullptr), data(data) {}
 
   };
   BinaryNode *head; // super head
@@ -258,21 +404,53 @@ private:
     head->right = head; // used for detecting illegal --begin() with empty collection
     head->parent = nullptr;
     size = 0;
+    Stats::allocation();
   }
 
+  // depth is the number of nodes visited, an equality and an ordering comparison made at all but the found one
   const_iterator search(BinaryNode *startNode, const key_type& key) const
   {
+    std::size_t depth = 0;
     while(startNode != nullptr) {
-        if(key == startNode->data.first)
+        depth++;
+        if(key == startNode->data.first) {
+            Stats::lookup(depth, 2 * depth - 1);
             return const_iterator(startNode);
+        }
         if(key < startNode->data.first)
             startNode = startNode->left;
         else
             startNode = startNode->right;
     }
+    Stats::lookup(depth, 2 * depth);
     return cend();
   }
 
+  // the leftmost node, head for an empty map
+  const BinaryNode* firstNode() const
+  {
+    if(head->left == head)
+      return head;
+    const BinaryNode *node = head->left;
+    while(node->left != nullptr)
+      node = node->left;
+    return node;
+  }
+
+  // the next node in key order, head after the last one
+  const BinaryNode* successor(const BinaryNode *node) const
+  {
+    if(node->right != nullptr) {
+      node = node->right;
+      while(node->left != nullptr)
+        node = node->left;
+      return node;
+    }
+    while(node->parent != head && node == node->parent->right)
+      node = node->parent;
+    return node->parent;
+  }
+
   BinaryNode* getMinimalSubtreeNode(BinaryNode *node)
   {
     while(node->left != nullptr)
@@ -292,13 +470,52 @@ private:
       node2->parent = node1->parent;
   }
 
-  void postOrderTraversalFreeingMemory(BinaryNode *node)
+  /*
+   * Copies the tree under root below head, node by node in pre-order along the parent links - iterative,
+   * as shapeReport(), so that a tree degenerated into a list does not overflow the stack.
+   * On a throw the nodes copied so far stay linked under head.
+   */
+  void copyTree(const BinaryNode *root)
+  {
+    BinaryNode *copy = new BinaryNode(root->data);
+    copy->parent = head;
+    head->left = copy;
+    const BinaryNode *source = root;
+    while(true) {
+      if(source->left != nullptr && copy->left == nullptr) {
+        copy->left = new BinaryNode(source->left->data);
+        copy->left->parent = copy;
+        source = source->left;
+        copy = copy->left;
+      } else if(source->right != nullptr && copy->right == nullptr) {
+        copy->right = new BinaryNode(source->right->data);
+        copy->right->parent = copy;
+        source = source->right;
+        copy = copy->right;
+      } else if(source == root) {
+        return;
+      } else {
+        source = source->parent;
+        copy = copy->parent;
+      }
+    }
+  }
+
+  // deletes the subtree without recursion: a left child is rotated up until the node has none, then it goes
+  void freeSubtree(BinaryNode *node)
   {
-    if(node->left != nullptr)
-      postOrderTraversalFreeingMemory(node->left);
-    if(node->right != nullptr)
-      postOrderTraversalFreeingMemory(node->right);
-    delete (node);
+    while(node != nullptr) {
+      if(node->left != nullptr) {
+        BinaryNode *left = node->left;
+        node->left = left->right;
+        left->right = node;
+        node = left;
+      } else {
+        BinaryNode *right = node->right;
+        delete node;
+        node = right;
+      }
+    }
   }
 
   void swap(TreeMap& first, TreeMap& second)
@@ -309,8 +526,8 @@ private:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Stats>
+class TreeMap<KeyType, ValueType, Stats>::ConstIterator
 {
 public:
   using reference = typename TreeMap::const_reference;
@@ -406,8 +623,49 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::Iterator : public TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Stats>
+class TreeMap<KeyType, ValueType, Stats>::LookupCursor
+{
+public:
+  explicit LookupCursor(BinaryNode *startNode, const key_type& key, const TreeMap& map)
+    : currentNode(startNode), key(&key), map(&map)
+  {
+    if(currentNode != nullptr)
+      prefetch(currentNode);
+  }
+
+  // descends one level and prefetches the next node, returns true when the search is over
+  bool step()
+  {
+    if(currentNode == nullptr)
+      return true;
+    if(*key == currentNode->data.first)
+      return true;
+    if(*key < currentNode->data.first)
+      currentNode = currentNode->left;
+    else
+      currentNode = currentNode->right;
+    if(currentNode == nullptr)
+      return true;
+    prefetch(currentNode);
+    return false;
+  }
+
+  const_iterator position() const
+  {
+    if(currentNode == nullptr)
+      return map->cend();
+    return const_iterator(currentNode);
+  }
+
+private:
+  BinaryNode *currentNode;
+  const key_type *key;
+  const TreeMap *map;
+};
+
+template <typename KeyType, typename ValueType, typename Stats>
+class TreeMap<KeyType, ValueType, Stats>::Iterator : public TreeMap<KeyType, ValueType, Stats>::ConstIterator
 {
 public:
   using reference = typename TreeMap::reference;
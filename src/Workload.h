@@ -0,0 +1,328 @@
+#ifndef AISDI_MAPS_WORKLOAD_H
+#define AISDI_MAPS_WORKLOAD_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace aisdi
+{
+
+// xoshiro256** - fast, small state, good enough for generating benchmark keys (not for anything secret).
+class Xoshiro256
+{
+public:
+  using result_type = std::uint64_t;
+
+  explicit Xoshiro256(std::uint64_t seed = 1)
+  {
+    for(auto& word : state) { // splitmix64, so that similar seeds give unrelated states
+      seed += 0x9e3779b97f4a7c15ull;
+      std::uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      word = z ^ (z >> 31);
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  result_type operator()()
+  {
+    const std::uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+    const std::uint64_t shifted = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= shifted;
+    state[3] = rotateLeft(state[3], 45);
+    return result;
+  }
+
+  // uniform in [0, 1)
+  double nextDouble()
+  {
+    return static_cast<double>(operator()() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  // uniform in [0, bound)
+  std::uint64_t nextBelow(std::uint64_t bound)
+  {
+    return std::uniform_int_distribution<std::uint64_t>(0, bound - 1)(*this);
+  }
+
+private:
+  std::uint64_t state[4];
+
+  static std::uint64_t rotateLeft(std::uint64_t x, int bits)
+  {
+    return (x << bits) | (x >> (64 - bits));
+  }
+};
+
+/*
+ * Zipf distribution over ranks 1..n, P(k) ~ 1 / k^exponent, exponent > 0.
+ * Rejection-inversion sampling (Hormann, Derflinger) - constant time and memory per sample, whatever n.
+ */
+class ZipfDistribution
+{
+public:
+  ZipfDistribution(std::uint64_t n, double exponent) : n(n), exponent(exponent)
+  {
+    if(n == 0 || !(exponent > 0))
+      throw std::invalid_argument("zipf needs n > 0 and a positive exponent");
+    hIntegralX1 = hIntegral(1.5) - 1;
+    hIntegralN = hIntegral(n + 0.5);
+    s = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+  }
+
+  template <typename Generator>
+  std::uint64_t operator()(Generator& generator) const
+  {
+    while(true) {
+      const double u = hIntegralN + generator.nextDouble() * (hIntegralX1 - hIntegralN);
+      const double x = hIntegralInverse(u);
+      double k = std::floor(x + 0.5);
+      if(k < 1)
+        k = 1;
+      else if(k > n)
+        k = static_cast<double>(n);
+      if(k - x <= s || u >= hIntegral(k + 0.5) - h(k))
+        return static_cast<std::uint64_t>(k);
+    }
+  }
+
+private:
+  std::uint64_t n;
+  double exponent;
+  double hIntegralX1, hIntegralN, s;
+
+  double h(double x) const
+  {
+    return std::exp(-exponent * std::log(x));
+  }
+
+  double hIntegral(double x) const
+  {
+    const double logX = std::log(x);
+    return expm1OverX((1 - exponent) * logX) * logX;
+  }
+
+  double hIntegralInverse(double x) const
+  {
+    double t = x * (1 - exponent);
+    if(t < -1)
+      t = -1;
+    return std::exp(log1pOverX(t) * x);
+  }
+
+  static double expm1OverX(double x)
+  {
+    return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x / 2 * (1 + x / 3 * (1 + x / 4));
+  }
+
+  static double log1pOverX(double x)
+  {
+    return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - x / 4));
+  }
+};
+
+enum class KeyDistribution { UNIFORM, SEQUENTIAL, REVERSE, STRIDED, CLUSTERED, ZIPF };
+
+inline KeyDistribution parseKeyDistribution(const std::string& name)
+{
+  const std::pair<const char*, KeyDistribution> names[] = {
+    { "uniform", KeyDistribution::UNIFORM }, { "sequential", KeyDistribution::SEQUENTIAL },
+    { "reverse", KeyDistribution::REVERSE }, { "strided", KeyDistribution::STRIDED },
+    { "clustered", KeyDistribution::CLUSTERED }, { "zipf", KeyDistribution::ZIPF } };
+  for(const auto& entry : names)
+    if(name == entry.first)
+      return entry.second;
+  throw std::invalid_argument("unknown key distribution: " + name);
+}
+
+/*
+ * Keys come from [0, keySpace), except for STRIDED, which multiplies them by stride.
+ *   SEQUENTIAL / REVERSE - 0, 1, 2, ... / keySpace - 1, keySpace - 2, ..., wrapping around,
+ *   STRIDED   - 0, stride, 2 * stride, ..., hitting the same low bits (and buckets) over and over,
+ *   CLUSTERED - runs of clusterSize consecutive keys starting at random points,
+ *   ZIPF      - key k - 1 with probability ~ 1 / k^zipfExponent, so 0 is the hottest key.
+ */
+struct KeyStreamConfig
+{
+  KeyDistribution distribution = KeyDistribution::UNIFORM;
+  std::uint64_t keySpace = 1000000;
+  double zipfExponent = 0.99;
+  std::uint64_t stride = 4096;
+  std::uint64_t clusterSize = 64;
+};
+
+inline std::vector<std::uint64_t> generateKeyStream(const KeyStreamConfig& config, std::size_t count,
+                                                    Xoshiro256& generator)
+{
+  if(config.keySpace == 0)
+    throw std::invalid_argument("key space must not be empty");
+  std::vector<std::uint64_t> keys(count);
+  if(config.distribution == KeyDistribution::ZIPF) {
+    const ZipfDistribution zipf(config.keySpace, config.zipfExponent);
+    for(auto& key : keys)
+      key = zipf(generator) - 1;
+    return keys;
+  }
+
+  const std::uint64_t clusterSize = config.clusterSize == 0 ? 1 : config.clusterSize;
+  std::uint64_t clusterStart = 0;
+  for(std::size_t i = 0; i < count; i++) {
+    switch(config.distribution) {
+    case KeyDistribution::SEQUENTIAL:
+      keys[i] = i % config.keySpace;
+      break;
+    case KeyDistribution::REVERSE:
+      keys[i] = config.keySpace - 1 - i % config.keySpace;
+      break;
+    case KeyDistribution::STRIDED:
+      keys[i] = (i % config.keySpace) * config.stride;
+      break;
+    case KeyDistribution::CLUSTERED:
+      if(i % clusterSize == 0)
+        clusterStart = generator.nextBelow(config.keySpace);
+      keys[i] = (clusterStart + i % clusterSize) % config.keySpace;
+      break;
+    default:
+      keys[i] = generator.nextBelow(config.keySpace);
+    }
+  }
+  return keys;
+}
+
+enum class OperationType : std::uint8_t { READ, WRITE, REMOVE };
+
+struct Operation
+{
+  OperationType type;
+  std::uint64_t key;
+};
+
+// relative weights, e.g. { 90, 8, 2 }
+struct OperationMix
+{
+  double reads = 1;
+  double writes = 0;
+  double removes = 0;
+};
+
+inline std::vector<Operation> generateWorkload(const KeyStreamConfig& config, const OperationMix& mix,
+                                               std::size_t count, Xoshiro256& generator)
+{
+  const double total = mix.reads + mix.writes + mix.removes;
+  if(!(total > 0) || mix.reads < 0 || mix.writes < 0 || mix.removes < 0)
+    throw std::invalid_argument("operation mix needs non-negative weights and a positive sum");
+
+  const auto keys = generateKeyStream(config, count, generator);
+  std::vector<Operation> operations(count);
+  for(std::size_t i = 0; i < count; i++) {
+    const double draw = generator.nextDouble() * total;
+    operations[i].key = keys[i];
+    if(draw < mix.reads)
+      operations[i].type = OperationType::READ;
+    else if(draw < mix.reads + mix.writes)
+      operations[i].type = OperationType::WRITE;
+    else
+      operations[i].type = OperationType::REMOVE;
+  }
+  return operations;
+}
+
+/*
+ * Binary traces: the 8 byte magic "AISDITR1", then 9 byte records - the operation type
+ * and the key as a little-endian 64-bit number.
+ * Files without the magic are read as raw little-endian 64-bit keys (e.g. dumped from access logs),
+ * each replayed as a read.
+ */
+const char TRACE_MAGIC[] = "AISDITR1";
+
+inline void writeTrace(const std::string& path, const std::vector<Operation>& operations)
+{
+  std::ofstream file(path, std::ios::binary);
+  file.write(TRACE_MAGIC, 8);
+  for(const auto& operation : operations) {
+    char record[9];
+    record[0] = static_cast<char>(operation.type);
+    for(int i = 0; i < 8; i++)
+      record[1 + i] = static_cast<char>((operation.key >> (8 * i)) & 0xff);
+    file.write(record, sizeof(record));
+  }
+  if(!file)
+    throw std::runtime_error("cannot write trace " + path);
+}
+
+inline std::vector<Operation> readTrace(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if(!file)
+    throw std::runtime_error("cannot open trace " + path);
+  const std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  const auto readKey = [&bytes](std::size_t offset) {
+    std::uint64_t key = 0;
+    for(int i = 0; i < 8; i++)
+      key |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[offset + i])) << (8 * i);
+    return key;
+  };
+
+  std::vector<Operation> operations;
+  if(bytes.size() >= 8 && std::memcmp(bytes.data(), TRACE_MAGIC, 8) == 0) {
+    if((bytes.size() - 8) % 9 != 0)
+      throw std::runtime_error("truncated trace " + path);
+    for(std::size_t offset = 8; offset < bytes.size(); offset += 9) {
+      const auto type = static_cast<unsigned char>(bytes[offset]);
+      if(type > static_cast<unsigned char>(OperationType::REMOVE))
+        throw std::runtime_error("unknown operation in trace " + path);
+      operations.push_back({ static_cast<OperationType>(type), readKey(offset + 1) });
+    }
+  } else {
+    if(bytes.size() % 8 != 0)
+      throw std::runtime_error("truncated trace " + path);
+    for(std::size_t offset = 0; offset < bytes.size(); offset += 8)
+      operations.push_back({ OperationType::READ, readKey(offset) });
+  }
+  return operations;
+}
+
+// Runs operation against map, the key converted to its key_type. True for a read that hit.
+template <typename M>
+bool replayOne(M& map, const Operation& operation)
+{
+  const auto key = static_cast<typename M::key_type>(operation.key);
+  if(operation.type == OperationType::READ)
+    return map.tryGet(key) != nullptr;
+  if(operation.type == OperationType::WRITE)
+    map[key] = typename M::mapped_type();
+  else if(map.tryGet(key) != nullptr)
+    map.remove(key);
+  return false;
+}
+
+// Runs operations against map. Returns the number of reads that hit.
+template <typename M>
+std::size_t replay(M& map, const std::vector<Operation>& operations)
+{
+  std::size_t hits = 0;
+  for(const auto& operation : operations)
+    hits += replayOne(map, operation);
+  return hits;
+}
+
+}
+
+#endif /* AISDI_MAPS_WORKLOAD_H */
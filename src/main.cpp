@@ -4,75 +4,1204 @@
 #include <vector>
 #include <ctime>
 #include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <memory>
+#include <functional>
+#include <string_view>
+#include <stdexcept>
+#include <cstdint>
+#include <sstream>
+#include <fstream>
+#include <array>
+#include <utility>
+#include <numeric>
 
 #include "TreeMap.h"
 #include "HashMap.h"
+#include "InterleavedLookup.h"
+#include "Benchmark.h"
+#include "Workload.h"
+#include "MapAdapters.h"
+#include "FlatMap.h"
+#include "AdaptiveMap.h"
+#include "DenseIntMap.h"
+#include "FrozenHashMap.h"
+#include "StaticMap.h"
+#include "CuckooHashMap.h"
+#include "FlatHashMap.h"
+#include "SplitHashMap.h"
+#define AISDI_DEFINE_ALLOCATION_COUNTER
+#include "AllocationCounter.h"
+#include "PerfCounters.h"
 
-const int MAX_KEY_VALUE = 100000;
+namespace
+{
+
+template <typename F>
+double measureNanosecondsPerOperation(std::size_t repeatCount, std::size_t noOperations, F operation)
+{
+  aisdi::BenchmarkConfig config;
+  config.warmups = 0;
+  config.repetitions = repeatCount;
+  return aisdi::measure(config, noOperations, []() {}, operation).bestNsPerOperation;
+}
 
-const int ITERATING = 4;
-const int ACCESSING = 8;
+// compares plain find() with interleavedFind() for growing maps, best of repeatCount runs
+template <typename M>
+void perfomInterleavedTest(std::size_t repeatCount, std::size_t maxElements)
+{
+  const std::size_t noLookups = 1000000;
+  const std::size_t groupSizes[] = { 1, 2, 4, 8, 16, 32 };
+  std::mt19937 generator(time(0));
 
-namespace
+  std::cout << "elements\tgroup\tns/lookup" << std::endl;
+  for(std::size_t noElements = 10000; noElements <= maxElements; noElements *= 10) {
+    M map;
+    std::vector<int> keys(noElements);
+    for(auto& key : keys) {
+      key = static_cast<int>(generator() >> 1);
+      map[key] = key;
+    }
+    std::vector<int> lookups(noLookups);
+    for(auto& key : lookups)
+      key = keys[generator() % noElements];
+
+    volatile std::size_t sink = 0;
+    double nsPerLookup = measureNanosecondsPerOperation(repeatCount, noLookups, [&]() {
+      std::size_t found = 0;
+      for(const auto& key : lookups)
+        found += map.find(key) != map.end();
+      sink = found;
+    });
+    std::cout << noElements << "\tfind\t" << nsPerLookup << std::endl;
+
+    for(std::size_t groupSize : groupSizes) {
+      nsPerLookup = measureNanosecondsPerOperation(repeatCount, noLookups, [&]() {
+        std::size_t found = 0;
+        aisdi::interleavedFind(map, lookups.data(), lookups.size(), groupSize,
+          [&](std::size_t, typename M::const_iterator position) { found += position != map.cend(); });
+        sink = found;
+      });
+      std::cout << noElements << "\t" << groupSize << "\t" << nsPerLookup << std::endl;
+    }
+    (void)sink;
+  }
+}
+
+enum class KeyPattern { UNIFORM, STRIDED, CLUSTERED };
+
+std::vector<int> generateKeys(KeyPattern pattern, std::size_t noElements, std::mt19937& generator)
+{
+  const int STRIDE = 1 << 14;
+  const std::size_t CLUSTER_SIZE = 64;
+  std::vector<int> keys(noElements);
+  for(std::size_t i = 0; i < noElements; i++) {
+    if(pattern == KeyPattern::UNIFORM)
+      keys[i] = static_cast<int>(generator() >> 1);
+    else if(pattern == KeyPattern::STRIDED)
+      keys[i] = static_cast<int>(i) * STRIDE;
+    else if(i % CLUSTER_SIZE == 0)
+      keys[i] = static_cast<int>(generator() >> 2);
+    else
+      keys[i] = keys[i - 1] + 1;
+  }
+  std::shuffle(keys.begin(), keys.end(), generator);
+  return keys;
+}
+
+// insert and lookup cost of one hash function for the given key pattern, best of repeatCount runs
+template <typename M>
+void perfomHashingTest(const char* name, const std::vector<int>& keys, std::size_t repeatCount)
+{
+  double bestInsert = std::numeric_limits<double>::max();
+  std::unique_ptr<M> map;
+  for(std::size_t i = 0; i < repeatCount; i++) {
+    map.reset(new M);
+    const auto start = std::chrono::steady_clock::now();
+    for(const auto& key : keys)
+      (*map)[key] = key;
+    const auto stop = std::chrono::steady_clock::now();
+    bestInsert = std::min(bestInsert, std::chrono::duration<double, std::nano>(stop - start).count());
+  }
+
+  volatile long int sink = 0;
+  const double nsPerLookup = measureNanosecondsPerOperation(repeatCount, keys.size(), [&]() {
+    long int sum = 0;
+    for(const auto& key : keys)
+      sum += map->valueOf(key);
+    sink = sum;
+  });
+  (void)sink;
+  std::cout << name << "\t" << bestInsert / keys.size() << "\t" << nsPerLookup << std::endl;
+}
+
+void perfomHashingTests(std::size_t repeatCount, std::size_t noElements)
+{
+  const std::pair<KeyPattern, const char*> patterns[] = {
+    { KeyPattern::UNIFORM, "uniform" }, { KeyPattern::STRIDED, "strided" }, { KeyPattern::CLUSTERED, "clustered" } };
+  std::mt19937 generator(time(0));
+
+  std::cout << "pattern\thash\tns/insert\tns/lookup" << std::endl;
+  for(const auto& pattern : patterns) {
+    const auto keys = generateKeys(pattern.first, noElements, generator);
+    std::cout << pattern.second << "\t";
+    perfomHashingTest< aisdi::HashMap<int, long int, std::hash<int>> >("std::hash", keys, repeatCount);
+    std::cout << pattern.second << "\t";
+    perfomHashingTest< aisdi::HashMap<int, long int> >("aisdi::Hash", keys, repeatCount);
+  }
+}
+
+// insert, hit and miss cost of a map, best of repeatCount runs
+template <typename M, typename K>
+void perfomCachedHashTest(const char* name, const std::vector<K>& keys, const std::vector<K>& missingKeys,
+                          std::size_t repeatCount)
+{
+  double bestInsert = std::numeric_limits<double>::max();
+  std::unique_ptr<M> map;
+  for(std::size_t i = 0; i < repeatCount; i++) {
+    map.reset(new M);
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t j = 0; j < keys.size(); j++)
+      (*map)[keys[j]] = j;
+    const auto stop = std::chrono::steady_clock::now();
+    bestInsert = std::min(bestInsert, std::chrono::duration<double, std::nano>(stop - start).count());
+  }
+
+  volatile long int sink = 0;
+  const double nsPerHit = measureNanosecondsPerOperation(repeatCount, keys.size(), [&]() {
+    long int sum = 0;
+    for(const auto& key : keys)
+      sum += map->valueOf(key);
+    sink = sum;
+  });
+  const double nsPerMiss = measureNanosecondsPerOperation(repeatCount, missingKeys.size(), [&]() {
+    long int found = 0;
+    for(const auto& key : missingKeys)
+      found += map->find(key) != map->end();
+    sink = found;
+  });
+  (void)sink;
+  std::cout << name << "\t" << bestInsert / keys.size() << "\t" << nsPerHit << "\t" << nsPerMiss << std::endl;
+}
+
+// long keys sharing a prefix, so that comparing two of them is expensive
+std::vector<std::string> generateStringKeys(const std::vector<int>& numbers)
+{
+  std::vector<std::string> keys;
+  for(const auto& number : numbers)
+    keys.push_back("tenant:default:session-cache:entry:" + std::to_string(number));
+  return keys;
+}
+
+void perfomCachedHashTests(std::size_t repeatCount, std::size_t noElements)
+{
+  std::mt19937 generator(time(0));
+  auto numbers = generateKeys(KeyPattern::CLUSTERED, 2 * noElements, generator);
+  std::sort(numbers.begin(), numbers.end());
+  numbers.erase(std::unique(numbers.begin(), numbers.end()), numbers.end());
+  std::shuffle(numbers.begin(), numbers.end(), generator);
+  const std::vector<int> keys(numbers.begin(), numbers.begin() + numbers.size() / 2);
+  const std::vector<int> missingKeys(numbers.begin() + numbers.size() / 2, numbers.end());
+
+  std::cout << "keys\tns/insert\tns/hit\tns/miss" << std::endl;
+  perfomCachedHashTest< aisdi::HashMap<int, long int, aisdi::Hash<int>, std::equal_to<int>, false> >(
+    "int", keys, missingKeys, repeatCount);
+  perfomCachedHashTest< aisdi::HashMap<int, long int, aisdi::Hash<int>, std::equal_to<int>, true> >(
+    "int+cache", keys, missingKeys, repeatCount);
+
+  const auto stringKeys = generateStringKeys(keys);
+  const auto missingStringKeys = generateStringKeys(missingKeys);
+  using StringHash = aisdi::Hash<std::string>;
+  using StringEqual = std::equal_to<std::string>;
+  perfomCachedHashTest< aisdi::HashMap<std::string, long int, StringHash, StringEqual, false> >(
+    "string", stringKeys, missingStringKeys, repeatCount);
+  perfomCachedHashTest< aisdi::HashMap<std::string, long int, StringHash, StringEqual, true> >(
+    "string+cache", stringKeys, missingStringKeys, repeatCount);
+}
+
+// looking up string keys given as std::string, a temporary std::string, const char* and std::string_view
+void perfomStringKeyTests(std::size_t repeatCount, std::size_t noElements)
+{
+  const std::pair<const char*, const char*> keyFormats[] = {
+    { "short", "id:" }, { "long", "tenant:default:session-cache:entry:" } };
+  std::mt19937 generator(time(0));
+
+  std::cout << "keys\tlookup by\tns/lookup" << std::endl;
+  for(const auto& format : keyFormats) {
+    aisdi::HashMap<std::string, long int> map;
+    std::vector<std::string> keys;
+    for(std::size_t i = 0; i < noElements; i++) {
+      keys.push_back(format.second + std::to_string(generator() % 100000000));
+      map[keys.back()] = i;
+    }
+    std::vector<std::string> strings;
+    std::vector<const char*> cStrings;
+    std::vector<std::string_view> views;
+    for(std::size_t i = 0; i < noElements; i++) {
+      const auto& key = keys[generator() % noElements];
+      strings.push_back(key);
+      cStrings.push_back(key.c_str());
+      views.push_back(key);
+    }
+
+    volatile long int sink = 0;
+    double nsPerLookup = measureNanosecondsPerOperation(repeatCount, noElements, [&]() {
+      long int sum = 0;
+      for(const auto& key : strings)
+        sum += map.find(key)->second;
+      sink = sum;
+    });
+    std::cout << format.first << "\tstd::string\t" << nsPerLookup << std::endl;
+    nsPerLookup = measureNanosecondsPerOperation(repeatCount, noElements, [&]() {
+      long int sum = 0;
+      for(const auto& key : cStrings)
+        sum += map.find(std::string(key))->second;
+      sink = sum;
+    });
+    std::cout << format.first << "\ttemporary\t" << nsPerLookup << std::endl;
+    nsPerLookup = measureNanosecondsPerOperation(repeatCount, noElements, [&]() {
+      long int sum = 0;
+      for(const auto& key : cStrings)
+        sum += map.find(key)->second;
+      sink = sum;
+    });
+    std::cout << format.first << "\tconst char*\t" << nsPerLookup << std::endl;
+    nsPerLookup = measureNanosecondsPerOperation(repeatCount, noElements, [&]() {
+      long int sum = 0;
+      for(const auto& key : views)
+        sum += map.find(key)->second;
+      sink = sum;
+    });
+    std::cout << format.first << "\tstring_view\t" << nsPerLookup << std::endl;
+    (void)sink;
+  }
+}
+
+// weak user hash: keys equal modulo 2^16 collide completely, whatever the seed of the map
+struct TruncatingHash
+{
+  std::size_t operator()(int key) const
+  {
+    return static_cast<std::size_t>(key & 0xffff);
+  }
+};
+
+// replays keys crafted against a fixed bucket count and against a weak hash function
+void perfomAdversarialTests(std::size_t repeatCount)
+{
+  const std::size_t sizes[] = { 1000, 4000, 16000, 32000 };
+  std::mt19937 generator(time(0));
+
+  std::cout << "keys\thash\tns/insert\tns/lookup" << std::endl;
+  for(std::size_t noElements : sizes) {
+    std::vector<int> keys(noElements);
+    for(std::size_t i = 0; i < noElements; i++)
+      keys[i] = static_cast<int>(i) << 16;
+    std::shuffle(keys.begin(), keys.end(), generator);
+
+    std::cout << noElements << "\t";
+    perfomHashingTest< aisdi::HashMap<int, long int, std::hash<int>> >("std::hash", keys, repeatCount);
+    std::cout << noElements << "\t";
+    perfomHashingTest< aisdi::HashMap<int, long int> >("aisdi::Hash", keys, repeatCount);
+    std::cout << noElements << "\t";
+    perfomHashingTest< aisdi::HashMap<int, long int, TruncatingHash> >("truncating", keys, repeatCount);
+  }
+}
+
+// lookup cost at 0%, 50% and 100% misses: find(), tryGet() and valueOf() with the exception caught
+template <typename M>
+void perfomMissRateTest(std::size_t repeatCount, std::size_t noElements)
+{
+  std::mt19937 generator(time(0));
+  std::vector<int> keys(noElements);
+  for(std::size_t i = 0; i < noElements; i++)
+    keys[i] = 2 * static_cast<int>(i); // odd keys are never present
+  std::shuffle(keys.begin(), keys.end(), generator);
+  M map;
+  for(const auto& key : keys)
+    map[key] = key;
+
+  std::cout << "miss%\tns/find\tns/tryGet\tns/valueOf+catch" << std::endl;
+  for(int missPercent : { 0, 50, 100 }) {
+    std::vector<int> lookups(keys);
+    std::uniform_int_distribution<int> percent(0, 99);
+    for(auto& key : lookups)
+      if(percent(generator) < missPercent)
+        key += 1;
+
+    volatile long int sink = 0;
+    const double nsPerFind = measureNanosecondsPerOperation(repeatCount, lookups.size(), [&]() {
+      long int sum = 0;
+      for(const auto& key : lookups) {
+        auto position = map.find(key);
+        if(position != map.end())
+          sum += position->second;
+      }
+      sink = sum;
+    });
+    const double nsPerTryGet = measureNanosecondsPerOperation(repeatCount, lookups.size(), [&]() {
+      long int sum = 0;
+      for(const auto& key : lookups)
+        if(const long int* value = map.tryGet(key))
+          sum += *value;
+      sink = sum;
+    });
+    const double nsPerValueOf = measureNanosecondsPerOperation(repeatCount, lookups.size(), [&]() {
+      long int sum = 0;
+      for(const auto& key : lookups) {
+        try {
+          sum += map.valueOf(key);
+        } catch(const std::out_of_range&) {
+        }
+      }
+      sink = sum;
+    });
+    (void)sink;
+    std::cout << missPercent << "\t" << nsPerFind << "\t" << nsPerTryGet << "\t" << nsPerValueOf << std::endl;
+  }
+}
+
+std::vector<std::string> splitList(const std::string& list)
+{
+  std::vector<std::string> items;
+  std::istringstream stream(list);
+  for(std::string item; std::getline(stream, item, ','); )
+    if(!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+struct HarnessOptions
+{
+  std::vector<std::string> maps = { "tree", "hash", "std::map", "std::unordered_map" };
+  std::string baseline; // empty - std::map when measured, otherwise the first map
+  std::vector<std::size_t> sizes = { 1000, 10000, 100000, 1000000 };
+  std::vector<std::string> operations = { "insert", "hit", "miss", "iterate", "remove", "copy" };
+  aisdi::BenchmarkConfig config;
+  std::uint32_t seed = 1;
+  bool json = false;
+  bool counters = false;
+  std::string latencyDump; // histograms of per-operation latencies go there, when --latency is set
+  // workload mode, replaces the operations above when workload or trace is set
+  std::string workload;
+  std::string trace;
+  std::string saveTrace;
+  aisdi::KeyStreamConfig keyStream;
+  aisdi::OperationMix mix;
+  std::size_t count = 0; // 0 - as many operations as elements
+  std::uint64_t keySpace = 0; // 0 - twice as many keys as elements
+};
+
+void printUsage(std::ostream& out)
+{
+  out << "usage: aisdiMaps [--map tree,hash,flat,adaptive,cuckoo,flathash,splithash,std::map,std::unordered_map,sorted_vector] [--baseline MAP] [--sizes 1e3,1e4,...] [--ops insert,hit,miss,iterate,remove,copy]\n"
+         "                 [--reps N] [--warmup N] [--seed N] [--json] [--counters] [--latency BATCH] [--latency-dump FILE]\n"
+         "                 [--workload uniform|sequential|reverse|strided|clustered|zipf | --trace FILE]\n"
+         "                 [--mix reads,writes,removes] [--count N] [--keyspace N] [--zipf S] [--stride N]\n"
+         "                 [--save-trace FILE]\n"
+         "       aisdiMaps repeat_count T|H [scenario [args]] [--reps N] [--warmup N] [--seed N] [--json] [--counters] [--latency BATCH]" << std::endl;
+}
+
+// false on malformed arguments
+bool parseHarnessOptions(int argc, char** argv, HarnessOptions& options)
+{
+  for(int i = 1; i < argc; i++) {
+    const std::string option = argv[i];
+    if(option == "--json" || option == "--counters") {
+      (option == "--json" ? options.json : options.counters) = true;
+      continue;
+    }
+    if(i + 1 >= argc)
+      return false;
+    const std::string value = argv[++i];
+    try {
+      if(option == "--map")
+        options.maps = splitList(value);
+      else if(option == "--baseline")
+        options.baseline = value;
+      else if(option == "--ops")
+        options.operations = splitList(value);
+      else if(option == "--sizes") {
+        options.sizes.clear();
+        for(const auto& size : splitList(value))
+          options.sizes.push_back(static_cast<std::size_t>(std::stod(size))); // accepts 1e6
+      }
+      else if(option == "--reps")
+        options.config.repetitions = std::stoul(value);
+      else if(option == "--warmup")
+        options.config.warmups = std::stoul(value);
+      else if(option == "--latency")
+        options.config.latencyBatch = std::stoul(value);
+      else if(option == "--latency-dump")
+        options.latencyDump = value;
+      else if(option == "--seed")
+        options.seed = static_cast<std::uint32_t>(std::stoul(value));
+      else if(option == "--workload") {
+        options.keyStream.distribution = aisdi::parseKeyDistribution(value);
+        options.workload = value;
+      }
+      else if(option == "--trace")
+        options.trace = value;
+      else if(option == "--save-trace")
+        options.saveTrace = value;
+      else if(option == "--mix") {
+        const auto weights = splitList(value);
+        if(weights.size() != 3)
+          return false;
+        options.mix.reads = std::stod(weights[0]);
+        options.mix.writes = std::stod(weights[1]);
+        options.mix.removes = std::stod(weights[2]);
+      }
+      else if(option == "--count")
+        options.count = static_cast<std::size_t>(std::stod(value));
+      else if(option == "--keyspace")
+        options.keySpace = static_cast<std::uint64_t>(std::stod(value));
+      else if(option == "--zipf")
+        options.keyStream.zipfExponent = std::stod(value);
+      else if(option == "--stride")
+        options.keyStream.stride = static_cast<std::uint64_t>(std::stod(value));
+      else
+        return false;
+    } catch(const std::logic_error&) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// key number i of the seeded sequence, keys scattered over the whole int range
+// (multiplication by an odd constant is a bijection modulo 2^32, so they are distinct for i < 2^32)
+int scrambledKey(std::size_t i, std::uint32_t seed)
+{
+  return static_cast<int>((static_cast<std::uint32_t>(i) * 2654435761u) ^ seed);
+}
+
+/*
+ * 2 * size distinct keys: keys go into the map, missingKeys are never in it,
+ * lookups are the keys once more, in another order.
+ */
+void generateBenchmarkKeys(std::size_t size, std::uint32_t seed, std::vector<int>& keys,
+                           std::vector<int>& lookups, std::vector<int>& missingKeys)
+{
+  keys.resize(size);
+  missingKeys.resize(size);
+  for(std::size_t i = 0; i < size; i++) {
+    keys[i] = scrambledKey(2 * i, seed);
+    missingKeys[i] = scrambledKey(2 * i + 1, seed);
+  }
+  lookups = keys;
+  std::shuffle(lookups.begin(), lookups.end(), std::mt19937(seed));
+}
+
+template <typename M>
+struct MapType
+{
+  using type = M;
+};
+
+// a lookup in the benchmarked cuckoo map reads at most two cache lines
+static_assert(aisdi::CuckooHashMap<int, long int>::bucketBytes() == aisdi::CACHE_LINE,
+              "a bucket of the benchmarked CuckooHashMap should be one cache line");
+
+// calls benchmark(name, MapType<M>()) with the map type named on the command line
+template <typename F>
+void withMapType(const std::string& map, F benchmark)
+{
+  if(map == "tree" || map == "T")
+    benchmark("tree", MapType< aisdi::TreeMap<int, long int> >());
+  else if(map == "hash" || map == "H")
+    benchmark("hash", MapType< aisdi::HashMap<int, long int> >());
+  else if(map == "std::map")
+    benchmark("std::map", MapType< aisdi::StdMap<int, long int> >());
+  else if(map == "std::unordered_map")
+    benchmark("std::unordered_map", MapType< aisdi::StdUnorderedMap<int, long int> >());
+  else if(map == "adaptive")
+    benchmark("adaptive", MapType< aisdi::AdaptiveMap<int, long int> >());
+  else if(map == "flat")
+    benchmark("flat", MapType< aisdi::FlatMap<int, long int> >());
+  else if(map == "sorted_vector")
+    benchmark("sorted_vector", MapType< aisdi::SortedVectorMap<int, long int> >());
+  else if(map == "cuckoo")
+    benchmark("cuckoo", MapType< aisdi::CuckooHashMap<int, long int> >());
+  else if(map == "flathash")
+    benchmark("flathash", MapType< aisdi::FlatHashMap<int, long int> >());
+  else if(map == "splithash")
+    benchmark("splithash", MapType< aisdi::SplitHashMap<int, long int> >());
+  else
+    throw std::invalid_argument("unknown map: " + map);
+}
+
+/*
+ * Each map is prefilled with keys 0..size-1 (in random order) and then runs the workload:
+ * a recorded trace, or operations generated with options.mix over a key space of
+ * --keyspace keys (2 * size by default, so that about half of the uniform reads hit).
+ */
+void runWorkload(const HarnessOptions& options, std::vector<aisdi::Measurement>& results)
+{
+  for(std::size_t size : options.sizes) {
+    aisdi::Xoshiro256 generator(options.seed);
+    std::vector<std::uint64_t> prefillKeys(size);
+    for(std::size_t i = 0; i < size; i++)
+      prefillKeys[i] = i;
+    std::shuffle(prefillKeys.begin(), prefillKeys.end(), generator);
+
+    std::vector<aisdi::Operation> operations;
+    std::string label;
+    if(!options.trace.empty()) {
+      operations = aisdi::readTrace(options.trace);
+      label = "trace";
+    } else {
+      aisdi::KeyStreamConfig keyStream = options.keyStream;
+      keyStream.keySpace = options.keySpace ? options.keySpace : 2 * std::max<std::uint64_t>(size, 1);
+      operations = aisdi::generateWorkload(keyStream, options.mix, options.count ? options.count : size, generator);
+      std::ostringstream name;
+      name << options.workload << ":" << options.mix.reads << "/" << options.mix.writes << "/" << options.mix.removes;
+      label = name.str();
+    }
+    if(!options.saveTrace.empty())
+      aisdi::writeTrace(options.saveTrace, operations);
+
+    for(const auto& map : options.maps)
+      withMapType(map, [&](const char* name, auto type) {
+        using M = typename decltype(type)::type;
+        aisdi::benchmarkWorkload<M>(name, label, prefillKeys, operations, options.config, results);
+      });
+  }
+}
+
+void runOperations(const HarnessOptions& options, std::vector<aisdi::Measurement>& results)
+{
+  for(std::size_t size : options.sizes) {
+    std::vector<int> keys, lookups, missingKeys;
+    generateBenchmarkKeys(size, options.seed, keys, lookups, missingKeys);
+    for(const auto& map : options.maps)
+      withMapType(map, [&](const char* name, auto type) {
+        using M = typename decltype(type)::type;
+        aisdi::benchmarkMap<M>(name, keys, lookups, missingKeys, options.operations, options.config, results);
+      });
+  }
+}
+
+// reads hardware counters around measured runs when --counters is set and the counters can be opened
+void enableCounters(HarnessOptions& options, aisdi::PerfCounters& counters)
+{
+  if(!options.counters)
+    return;
+  if(counters.isAvailable())
+    options.config.counters = &counters;
+  else
+    std::cerr << "hardware counters unavailable, measuring time only: " << counters.unavailableReason() << std::endl;
+}
+
+void writeLatencyDump(const HarnessOptions& options, const std::vector<aisdi::Measurement>& results)
+{
+  if(options.latencyDump.empty())
+    return;
+  std::ofstream dump(options.latencyDump);
+  if(!dump)
+    throw std::runtime_error("cannot write " + options.latencyDump);
+  aisdi::dumpLatency(dump, results);
+}
+
+int runHarness(HarnessOptions options)
+{
+  aisdi::PerfCounters counters;
+  enableCounters(options, counters);
+
+  std::vector<aisdi::Measurement> results;
+  if(options.workload.empty() && options.trace.empty())
+    runOperations(options, results);
+  else
+    runWorkload(options, results);
+  writeLatencyDump(options, results);
+  if(options.json) {
+    aisdi::printJson(std::cout, results);
+    return 0;
+  }
+  aisdi::printText(std::cout, results);
+  if(options.maps.size() > 1 && !results.empty()) {
+    std::string baseline = options.baseline.empty() ? results.front().map : options.baseline;
+    for(const auto& result : results)
+      if(options.baseline.empty() && result.map == "std::map")
+        baseline = result.map;
+    aisdi::printComparison(std::cout, results, baseline);
+    aisdi::printCrossover(std::cout, results, baseline);
+  }
+  aisdi::printMemory(std::cout, results);
+  if(options.config.latencyBatch != 0)
+    aisdi::printLatency(std::cout, results, options.config.latencyBatch);
+  return 0;
+}
+
+/*
+ * A scenario of main() measures with the harness options (--reps, --warmup, --seed, --latency, --counters)
+ * and keeps every measurement. Its own table goes to std::cout, or to std::cerr with --json,
+ * when the measurements are printed as JSON instead.
+ */
+struct Scenario
+{
+  HarnessOptions options;
+  std::vector<aisdi::Measurement> results;
+
+  std::ostream& table() const
+  {
+    return options.json ? std::cerr : std::cout;
+  }
+};
+
+// records result as operation of map on size elements, returns its best ns per operation
+double record(Scenario& scenario, aisdi::Measurement result, const std::string& map,
+              const std::string& operation, std::size_t size)
+{
+  result.map = map;
+  result.operation = operation;
+  result.size = size;
+  scenario.results.push_back(result);
+  return result.bestNsPerOperation;
+}
+
+// times run() doing noOperations operations at once, each time after setup()
+template <typename Setup, typename Run>
+double timeRuns(Scenario& scenario, const std::string& map, const std::string& operation, std::size_t size,
+                std::size_t noOperations, Setup setup, Run run)
+{
+  return record(scenario, aisdi::measure(scenario.options.config, noOperations, setup, run), map, operation, size);
+}
+
+// times noOperations calls of step(i), each pass after setup(), with latencies when --latency is set
+template <typename Setup, typename Step>
+double timeSteps(Scenario& scenario, const std::string& map, const std::string& operation, std::size_t size,
+                 std::size_t noOperations, Setup setup, Step step)
 {
+  return record(scenario, aisdi::measureSteps(scenario.options.config, noOperations, setup, step),
+                map, operation, size);
+}
+
+// times tryGet() of every searched key, summing the values found so that no lookup can be left out
+template <typename M>
+double timeLookups(Scenario& scenario, const std::string& map, const std::string& operation, const M& searched,
+                   const std::vector<typename M::key_type>& keys)
+{
+  long int sum = 0;
+  const double nsPerLookup = timeSteps(scenario, map, operation, searched.getSize(), keys.size(), []() {},
+    [&](std::size_t i) {
+      if(const auto* value = searched.tryGet(keys[i]))
+        sum += *value;
+    });
+  volatile long int sink = sum;
+  (void)sink;
+  return nsPerLookup;
+}
+
+// runs the scenario, then prints its measurements as JSON with --json, or latencies when --latency is set
+template <typename F>
+int runScenario(Scenario& scenario, F run)
+{
+  aisdi::PerfCounters counters;
+  enableCounters(scenario.options, counters);
+  try {
+    run();
+    writeLatencyDump(scenario.options, scenario.results);
+  } catch(const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  if(scenario.options.json)
+    aisdi::printJson(std::cout, scenario.results);
+  else if(scenario.options.config.latencyBatch != 0)
+    aisdi::printLatency(std::cout, scenario.results, scenario.options.config.latencyBatch);
+  return 0;
+}
+
+// builds noMaps maps of noEntries entries each, then looks up random keys in random maps
+template <typename M>
+void perfomTinyMapTest(Scenario& scenario, const char* name, std::size_t noMaps, std::size_t noEntries)
+{
+  std::mt19937 generator(scenario.options.seed);
+  auto keyOf = [](std::size_t map, std::size_t entry) {
+    return static_cast<int>(map * 31 + entry * 1009);
+  };
+  auto fill = [&](std::vector<M>& maps) {
+    for(std::size_t map = 0; map < maps.size(); map++)
+      for(std::size_t entry = 0; entry < noEntries; entry++)
+        maps[map][keyOf(map, entry)] = static_cast<long int>(entry);
+  };
+
+  const double nsPerBuild = timeRuns(scenario, name, "build", noEntries, noMaps, []() {}, [&]() {
+    std::vector<M> maps(noMaps);
+    fill(maps);
+  });
 
-template <typename K, typename V>
-using Map = aisdi::HashMap<K, V>;
+  const std::size_t bytesBefore = aisdi::currentAllocations().liveBytes;
+  std::vector<M> maps(noMaps);
+  fill(maps);
+  // without the vector of the objects themselves - they are the sizeof column
+  const std::size_t heapBytes = aisdi::currentAllocations().liveBytes - bytesBefore - noMaps * sizeof(M);
+  const double heapBytesPerMap = double(heapBytes) / noMaps;
 
+  const std::size_t noLookups = 1000000;
+  std::vector<std::pair<std::size_t, int>> lookups(noLookups);
+  std::uniform_int_distribution<std::size_t> mapIndex(0, noMaps - 1);
+  std::uniform_int_distribution<std::size_t> entryIndex(0, noEntries - 1);
+  for(auto& lookup : lookups) {
+    lookup.first = mapIndex(generator);
+    lookup.second = keyOf(lookup.first, entryIndex(generator));
+  }
+  long int sum = 0;
+  const double nsPerLookup = timeSteps(scenario, name, "hit", noEntries, noLookups, []() {}, [&](std::size_t i) {
+    if(const long int* value = maps[lookups[i].first].tryGet(lookups[i].second))
+      sum += *value;
+  });
+  volatile long int sink = sum;
+  (void)sink;
+
+  scenario.table() << name << "\t" << sizeof(M) << "\t" << heapBytesPerMap << "\t" << sizeof(M) + heapBytesPerMap
+                   << "\t" << nsPerBuild << "\t" << nsPerLookup << std::endl;
+}
+
+// a population of tiny maps, as in a graph keeping a map per node: object and heap bytes per map dominate
+void perfomTinyMapTests(Scenario& scenario, std::size_t noMaps, std::size_t noEntries)
+{
+  scenario.table() << "map\tsizeof\theap B/map\ttotal B/map\tns/build\tns/lookup" << std::endl;
+  perfomTinyMapTest< aisdi::HashMap<int, long int> >(scenario, "HashMap", noMaps, noEntries);
+  perfomTinyMapTest< aisdi::HashMap<int, long int, aisdi::Hash<int>, aisdi::EqualTo<int>, false, aisdi::NoStats, 4> >(
+    scenario, "HashMap inline 4", noMaps, noEntries);
+  perfomTinyMapTest< aisdi::HashMap<int, long int, aisdi::Hash<int>, aisdi::EqualTo<int>, false, aisdi::NoStats, 8> >(
+    scenario, "HashMap inline 8", noMaps, noEntries);
+  perfomTinyMapTest< aisdi::AdaptiveMap<int, long int> >(scenario, "AdaptiveMap", noMaps, noEntries);
+  perfomTinyMapTest< aisdi::FlatMap<int, long int> >(scenario, "FlatMap", noMaps, noEntries);
+  perfomTinyMapTest< aisdi::TreeMap<int, long int> >(scenario, "TreeMap", noMaps, noEntries);
+}
+
+// insert, hit, miss and iteration at a given fill of a key range: direct addressing against hashing
 template <typename M>
-void perfomTest(int noElements, int whichOperations, M map) // we want fresh one in each iteration
+void perfomDenseTest(Scenario& scenario, const char* name, const std::vector<int>& keys,
+                     const std::vector<int>& lookups, const std::vector<int>& missingKeys)
 {
-  std::vector < std::pair <int, long int> > tab(noElements);
+  std::unique_ptr<M> scratch;
+  const double nsPerInsert = timeSteps(scenario, name, "insert", keys.size(), keys.size(),
+    [&]() { scratch.reset(new M); }, [&](std::size_t i) { (*scratch)[keys[i]] = keys[i]; });
+  M map;
+  for(const auto& key : keys)
+    map[key] = key;
 
-  // Array with noElements, element is a pair key-value
-  for(int i = 0; i < noElements; i++)
-    tab[i] = std::make_pair((rand() % MAX_KEY_VALUE), (rand() % 100000));
+  const double nsPerHit = timeLookups(scenario, name, "hit", map, lookups);
+  const double nsPerMiss = timeLookups(scenario, name, "miss", map, missingKeys);
+  volatile long int sink = 0;
+  const double nsPerIteration = timeRuns(scenario, name, "iterate", keys.size(), keys.size(), []() {}, [&]() {
+    long int sum = 0;
+    for(auto it = map.begin(); it != map.end(); ++it)
+      sum += it->second;
+    sink = sum;
+  });
+  (void)sink;
+  scenario.table() << "\t" << name << "\t" << nsPerInsert << "\t" << nsPerHit << "\t" << nsPerMiss
+                   << "\t" << nsPerIteration << std::endl;
+}
 
-  // 1) adding elements to the Map
-  for(auto it = tab.begin(); it < tab.end(); it++)
-    map[it->first] = it->second;
+// keys drawn from [0, 100000) - ports, small ids and the like - at growing fill of the range
+void perfomDenseTests(Scenario& scenario)
+{
+  const std::size_t MAX_KEY = 100000;
+  std::mt19937 generator(scenario.options.seed);
+  std::vector<int> range(MAX_KEY);
+  for(std::size_t i = 0; i < MAX_KEY; i++)
+    range[i] = static_cast<int>(i);
 
+  scenario.table() << "fill%\tmap\tns/insert\tns/hit\tns/miss\tns/iterated" << std::endl;
+  for(std::size_t fillPercent : { 1, 10, 50, 90 }) {
+    std::shuffle(range.begin(), range.end(), generator);
+    const std::size_t noElements = MAX_KEY * fillPercent / 100;
+    const std::vector<int> keys(range.begin(), range.begin() + noElements);
+    std::vector<int> lookups(keys);
+    std::shuffle(lookups.begin(), lookups.end(), generator);
+    const std::vector<int> missingKeys(range.begin() + noElements,
+                                       range.begin() + std::min(MAX_KEY, 2 * noElements));
 
-  // 2) iterating through the Map
-  if(whichOperations & ITERATING) {
-    std::cout << "iterating" << std::endl;
-    for(auto it = map.begin(); it != map.end(); it++)
-      (void)it->first;
+    scenario.table() << fillPercent;
+    perfomDenseTest< aisdi::DenseIntMap<int, long int, MAX_KEY> >(scenario, "DenseIntMap", keys, lookups, missingKeys);
+    scenario.table() << fillPercent;
+    perfomDenseTest< aisdi::HashMap<int, long int> >(scenario, "HashMap", keys, lookups, missingKeys);
   }
+}
+
+// build time of FrozenHashMap, then its lookups and footprint against the HashMap holding the same keys
+void perfomFrozenTests(Scenario& scenario, std::size_t maxElements)
+{
+  using Frozen = aisdi::FrozenHashMap<int, long int>;
+  scenario.table() << "elements\tns/key build\tns/hit\tns/miss\tB/key\tHashMap ns/hit\tns/miss\tB/key" << std::endl;
+  for(std::size_t noElements = 1000000; noElements <= maxElements; noElements *= 10) {
+    std::vector<int> keys, lookups, missingKeys;
+    generateBenchmarkKeys(noElements, scenario.options.seed, keys, lookups, missingKeys);
+    std::vector<std::pair<int, long int>> items(noElements);
+    for(std::size_t i = 0; i < noElements; i++)
+      items[i] = { keys[i], static_cast<long int>(i) };
 
-  // 3) accessing random keys
-  if(whichOperations & ACCESSING) {
-    std::cout << "accessing" << std::endl;
-    for(int i = 0; i < noElements; i++)
-      (void)map[ tab[rand() % noElements].first ];
+    const double nsPerBuild = timeRuns(scenario, "FrozenHashMap", "build", noElements, noElements, []() {}, [&]() {
+      Frozen::build(items);
+    });
+    scenario.table() << noElements << "\t" << nsPerBuild;
+
+    auto measureLookups = [&](const char* name, const auto& map) {
+      const double nsPerHit = timeLookups(scenario, name, "hit", map, lookups);
+      const double nsPerMiss = timeLookups(scenario, name, "miss", map, missingKeys);
+      scenario.table() << "\t" << nsPerHit << "\t" << nsPerMiss
+                       << "\t" << double(map.memoryUsage().heapBytes) / noElements;
+    };
+    {
+      const Frozen frozen = Frozen::build(items);
+      measureLookups("FrozenHashMap", frozen);
+    }
+    {
+      aisdi::HashMap<int, long int> chained;
+      for(const auto& item : items)
+        chained[item.first] = item.second;
+      measureLookups("HashMap", chained);
+    }
+    scenario.table() << std::endl;
   }
 }
 
+// a table of sizeof...(Index) opcode-like keys with their indexes, generated by the compiler
+template <std::size_t... Index>
+constexpr std::array<std::pair<int, long int>, sizeof...(Index)> opcodeTable(std::index_sequence<Index...>)
+{
+  return { { { static_cast<int>(Index * 37 + 1), static_cast<long int>(Index) }... } };
+}
+
+// startup and lookup cost of a fixed table: StaticMap made by the compiler against HashMap filled at run time
+void perfomStaticMapTests(Scenario& scenario)
+{
+  constexpr auto items = opcodeTable(std::make_index_sequence<64>());
+  constexpr auto table = aisdi::makeStaticMap(items);
+
+  const double nsPerHashMapBuild = timeRuns(scenario, "HashMap", "build", items.size(), 1, []() {}, [&]() {
+    aisdi::HashMap<int, long int> map;
+    for(const auto& item : items)
+      map[item.first] = item.second;
+  });
+  aisdi::HashMap<int, long int> map;
+  for(const auto& item : items)
+    map[item.first] = item.second;
+
+  std::mt19937 generator(scenario.options.seed);
+  std::vector<int> lookups(1000000);
+  for(auto& key : lookups)
+    key = items[generator() % items.size()].first + (generator() % 4 == 0); // a quarter misses
+  const double nsPerStaticLookup = timeLookups(scenario, "StaticMap", "lookup", table, lookups);
+  const double nsPerHashMapLookup = timeLookups(scenario, "HashMap", "lookup", map, lookups);
+
+  scenario.table() << "map\tns/build of " << items.size() << " entries\tns/lookup" << std::endl;
+  scenario.table() << "StaticMap\t0\t" << nsPerStaticLookup << std::endl;
+  scenario.table() << "HashMap\t" << nsPerHashMapBuild << "\t" << nsPerHashMapLookup << std::endl;
+}
+
+template <typename M>
+void perfomGroupProbeTest(Scenario& scenario, const char* name, const std::vector<int>& keys,
+                          const std::vector<int>& lookups, const std::vector<int>& missingKeys)
+{
+  M map;
+  for(const auto& key : keys)
+    map[key] = key;
+
+  const double nsPerHit = timeLookups(scenario, name, "hit", map, lookups);
+  const double nsPerMiss = timeLookups(scenario, name, "miss", map, missingKeys);
+  scenario.table() << "\t" << name << "\t" << nsPerHit << "\t" << nsPerMiss << std::endl;
+}
+
+// FlatHashMap probing 16 control bytes at once (SSE2 and SWAR kernels) against the chains of HashMap,
+// with the table filled to growing load factors - noSlots stays the capacity of the flat table
+void perfomGroupProbeTests(Scenario& scenario, std::size_t noSlots)
+{
+  using DefaultMap = aisdi::FlatHashMap<int, long int>;
+#ifdef AISDI_MAPS_HAVE_SSE2
+  const char* DEFAULT_NAME = "FlatHashMap SSE2";
+#else
+  const char* DEFAULT_NAME = "FlatHashMap";
+#endif
+  using ScalarMap = aisdi::FlatHashMap<int, long int, aisdi::Hash<int>, aisdi::EqualTo<int>, aisdi::ScalarGroup>;
+
+  scenario.table() << "load\tmap\tns/hit\tns/miss" << std::endl;
+  for(std::size_t loadPerMille : { 500, 750, 875 }) {
+    std::vector<int> keys, lookups, missingKeys;
+    generateBenchmarkKeys(noSlots * loadPerMille / 1000, scenario.options.seed, keys, lookups, missingKeys);
+
+    const double load = loadPerMille / 1000.0;
+    scenario.table() << load;
+    perfomGroupProbeTest<DefaultMap>(scenario, DEFAULT_NAME, keys, lookups, missingKeys);
+    scenario.table() << load;
+    perfomGroupProbeTest<ScalarMap>(scenario, "FlatHashMap SWAR", keys, lookups, missingKeys);
+    scenario.table() << load;
+    perfomGroupProbeTest< aisdi::HashMap<int, long int> >(scenario, "HashMap", keys, lookups, missingKeys);
+  }
+}
+
+// a table of constant size where every operation removes a random key and inserts a new one,
+// reported per round of noElements operations to show whether lookups degrade over time
+void perfomChurnTests(Scenario& scenario, std::size_t noElements, std::size_t noRounds)
+{
+  // the even keys of the sequence are inserted in turn, the odd ones are never in the map
+  std::size_t nextKey = 0;
+  aisdi::FlatHashMap<int, long int> map;
+  std::vector<int> keys(noElements), missingKeys(noElements);
+  for(std::size_t i = 0; i < noElements; i++) {
+    keys[i] = scrambledKey(2 * nextKey++, scenario.options.seed);
+    missingKeys[i] = scrambledKey(2 * i + 1, scenario.options.seed);
+    map[keys[i]] = keys[i];
+  }
+  std::mt19937 generator(scenario.options.seed);
+  std::uniform_int_distribution<std::size_t> victims(0, noElements - 1);
+  // every churn changes the map, so each round is timed once, without latencies
+  aisdi::BenchmarkConfig once;
+  once.warmups = 0;
+  once.repetitions = 1;
+  once.counters = scenario.options.config.counters;
+
+  scenario.table() << "round\tns/churn\tns/hit\tns/miss\tprobe length\tcapacity" << std::endl;
+  for(std::size_t round = 0; round <= noRounds; round++) {
+    const std::string label = "round " + std::to_string(round);
+    double nsPerChurn = 0;
+    if(round > 0)
+      nsPerChurn = record(scenario, aisdi::measure(once, noElements, []() {}, [&]() {
+        for(std::size_t i = 0; i < noElements; i++) {
+          int& victim = keys[victims(generator)];
+          map.remove(victim);
+          victim = scrambledKey(2 * nextKey++, scenario.options.seed);
+          map[victim] = victim;
+        }
+      }), "FlatHashMap", "churn " + label, noElements);
+
+    const double nsPerHit = timeLookups(scenario, "FlatHashMap", "hit " + label, map, keys);
+    const double nsPerMiss = timeLookups(scenario, "FlatHashMap", "miss " + label, map, missingKeys);
+    scenario.table() << round << "\t" << nsPerChurn << "\t" << nsPerHit << "\t" << nsPerMiss
+                     << "\t" << map.averageProbeLength() << "\t" << map.capacity() << std::endl;
+  }
+}
+
+// times summing the values of a map holding keys, one run of sum() covering every entry
+template <typename M, typename F>
+void perfomSumTest(Scenario& scenario, const char* name, const char* scan, const std::vector<int>& keys, F sum)
+{
+  M map;
+  for(const auto& key : keys)
+    map[key] = key & 0xff;
+
+  volatile long int sink = 0;
+  const double nsPerEntry = timeRuns(scenario, name, std::string("sum ") + scan, keys.size(), keys.size(),
+                                     []() {}, [&]() { sink = sum(map); });
+  (void)sink;
+  scenario.table() << name << "\t" << scan << "\t" << nsPerEntry << "\t"
+                   << static_cast<double>(map.memoryUsage().heapBytes) / keys.size() << std::endl;
+}
+
+template <typename M>
+void perfomSumValuesTest(Scenario& scenario, const char* name, const std::vector<int>& keys)
+{
+  perfomSumTest<M>(scenario, name, "iterator", keys, [](const M& map) {
+    long int sum = 0;
+    for(auto it = map.cbegin(); it != map.cend(); ++it)
+      sum += it->second;
+    return sum;
+  });
+}
+
+template <typename M>
+void perfomSumChunksTest(Scenario& scenario, const char* name, const std::vector<int>& keys)
+{
+  perfomSumTest<M>(scenario, name, "forEachChunk", keys, [](const M& map) {
+    long int sum = 0;
+    map.forEachChunk([&](const auto chunk) {
+      for(const auto *entry : chunk)
+        sum += entry->second;
+    });
+    return sum;
+  });
+}
+
+// aggregating the values of a big map: maps of pairs through iterators and pointer batches
+// against the value array of SplitHashMap
+void perfomSumValuesTests(Scenario& scenario, std::size_t noElements)
+{
+  std::vector<int> keys, lookups, missingKeys;
+  generateBenchmarkKeys(noElements, scenario.options.seed, keys, lookups, missingKeys);
+
+  using Split = aisdi::SplitHashMap<int, long int>;
+  scenario.table() << "map\tscan\tns/entry\tB/entry" << std::endl;
+  perfomSumValuesTest< aisdi::TreeMap<int, long int> >(scenario, "TreeMap", keys);
+  perfomSumChunksTest< aisdi::TreeMap<int, long int> >(scenario, "TreeMap", keys);
+  perfomSumValuesTest< aisdi::HashMap<int, long int> >(scenario, "HashMap", keys);
+  perfomSumChunksTest< aisdi::HashMap<int, long int> >(scenario, "HashMap", keys);
+  perfomSumValuesTest< aisdi::FlatHashMap<int, long int> >(scenario, "FlatHashMap", keys);
+  perfomSumChunksTest< aisdi::FlatHashMap<int, long int> >(scenario, "FlatHashMap", keys);
+  perfomSumValuesTest<Split>(scenario, "SplitHashMap", keys);
+  perfomSumTest<Split>(scenario, "SplitHashMap", "values()", keys, [](const Split& map) {
+    const auto values = map.values();
+    return std::accumulate(values.begin(), values.end(), 0l);
+  });
+}
+
 } // namespace
 
 int main(int argc, char** argv)
 {
-  // usage ./aisdiMaps repeat_count T|H
-  srand(time(0));
-  if(argc < 3) return -1;
-  const std::size_t repeatCount = argc > 1 ? std::atoll(argv[1]) : 1;
-  const int operation = ACCESSING|ITERATING;
-  const int noElements = 1000;
+  // usage ./aisdiMaps [--map tree,hash] [--sizes ...] [--ops ...] [--reps N] [--warmup N] [--seed N] [--json] [--latency N]
+  //       ./aisdiMaps repeat_count T|H [interleaved [max_elements]]
+  //       ./aisdiMaps repeat_count H hashing [elements]
+  //       ./aisdiMaps repeat_count H adversarial
+  //       ./aisdiMaps repeat_count H cachedhash [elements]
+  //       ./aisdiMaps repeat_count H stringkeys [elements]
+  //       ./aisdiMaps repeat_count T|H missrate [elements]
+  //       ./aisdiMaps repeat_count H tinymaps [maps [entries]]
+  //       ./aisdiMaps repeat_count H dense
+  //       ./aisdiMaps repeat_count H frozen [max_elements]
+  //       ./aisdiMaps repeat_count H static
+  //       ./aisdiMaps repeat_count H groupprobe [slots]
+  //       ./aisdiMaps repeat_count H churn [elements [rounds]]
+  //       ./aisdiMaps repeat_count H sumvalues [elements]
+  // tinymaps to sumvalues and the plain run of T|H also take --reps, --warmup, --seed, --json, --counters
+  // and --latency (--reps overrides repeat_count)
+  if(argc < 2 || std::string(argv[1]).compare(0, 2, "--") == 0) {
+    HarnessOptions options;
+    if(!parseHarnessOptions(argc, argv, options)) {
+      printUsage(std::cerr);
+      return 1;
+    }
+    try {
+      return runHarness(options);
+    } catch(const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      printUsage(std::cerr);
+      return 1;
+    }
+  }
+  // harness options may follow the scenario arguments
+  int noArguments = 1;
+  while(noArguments < argc && std::string(argv[noArguments]).compare(0, 2, "--") != 0)
+    noArguments++;
+  if(noArguments < 3) {
+    printUsage(std::cerr);
+    return 1;
+  }
+  const std::size_t repeatCount = std::atoll(argv[1]);
+  Scenario scenario;
+  scenario.options.config.repetitions = repeatCount;
+  if(!parseHarnessOptions(argc - noArguments + 1, argv + noArguments - 1, scenario.options)) {
+    printUsage(std::cerr);
+    return 1;
+  }
+
+  if(noArguments > 3 && std::string(argv[3]) == "interleaved") {
+    const std::size_t maxElements = noArguments > 4 ? std::atoll(argv[4]) : 1000000;
+    if((*argv[2]) == 'T') {
+      std::cout << "TreeMap interleaved lookup" << std::endl;
+      perfomInterleavedTest< aisdi::TreeMap<int, long int> >(repeatCount, maxElements);
+    } else if((*argv[2]) == 'H') {
+      std::cout << "HashMap interleaved lookup" << std::endl;
+      perfomInterleavedTest< aisdi::HashMap<int, long int> >(repeatCount, maxElements);
+    }
+    return 0;
+  }
 
+  if(noArguments > 3 && std::string(argv[3]) == "hashing") {
+    const std::size_t noElements = noArguments > 4 ? std::atoll(argv[4]) : 20000;
+    std::cout << "HashMap hashing of " << noElements << " keys" << std::endl;
+    perfomHashingTests(repeatCount, noElements);
+    return 0;
+  }
 
+  if(noArguments > 3 && std::string(argv[3]) == "adversarial") {
+    std::cout << "HashMap with adversarial keys" << std::endl;
+    perfomAdversarialTests(repeatCount);
+    return 0;
+  }
 
-  if((*argv[2]) == 'T') {
-    std::cout << "TreeMap" << std::endl;
-    aisdi::TreeMap<int, long int> map;
-    for (std::size_t i = 0; i < repeatCount; ++i)
-      perfomTest< aisdi::TreeMap<int, long int> > (noElements, operation, map);
+  if(noArguments > 3 && std::string(argv[3]) == "cachedhash") {
+    const std::size_t noElements = noArguments > 4 ? std::atoll(argv[4]) : 100000;
+    std::cout << "HashMap with and without cached hashes" << std::endl;
+    perfomCachedHashTests(repeatCount, noElements);
+    return 0;
   }
-  else if((*argv[2]) == 'H') {
-    std::cout << "HashMap" << std::endl;
-    aisdi::HashMap<int, long int> map;
-    for (std::size_t i = 0; i < repeatCount; ++i) {
-      perfomTest< aisdi::HashMap<int, long int> > (noElements, operation, map);
+
+  if(noArguments > 3 && std::string(argv[3]) == "stringkeys") {
+    const std::size_t noElements = noArguments > 4 ? std::atoll(argv[4]) : 100000;
+    std::cout << "HashMap with string keys" << std::endl;
+    perfomStringKeyTests(repeatCount, noElements);
+    return 0;
+  }
+  if(noArguments > 3 && std::string(argv[3]) == "missrate") {
+    const std::size_t noElements = noArguments > 4 ? std::atoll(argv[4]) : 100000;
+    if((*argv[2]) == 'T') {
+      std::cout << "TreeMap lookup misses" << std::endl;
+      perfomMissRateTest< aisdi::TreeMap<int, long int> >(repeatCount, noElements);
+    } else if((*argv[2]) == 'H') {
+      std::cout << "HashMap lookup misses" << std::endl;
+      perfomMissRateTest< aisdi::HashMap<int, long int> >(repeatCount, noElements);
     }
+    return 0;
+  }
+
+  if(noArguments > 3 && std::string(argv[3]) == "tinymaps") {
+    const std::size_t noMaps = noArguments > 4 ? std::atoll(argv[4]) : 1000000;
+    const std::size_t noEntries = noArguments > 5 ? std::atoll(argv[5]) : 4;
+    return runScenario(scenario, [&]() {
+      scenario.table() << noMaps << " maps of " << noEntries << " entries" << std::endl;
+      perfomTinyMapTests(scenario, noMaps, noEntries);
+    });
+  }
+
+  if(noArguments > 3 && std::string(argv[3]) == "dense")
+    return runScenario(scenario, [&]() {
+      scenario.table() << "DenseIntMap against HashMap over keys [0, 100000)" << std::endl;
+      perfomDenseTests(scenario);
+    });
+
+  if(noArguments > 3 && std::string(argv[3]) == "frozen") {
+    const std::size_t maxElements = noArguments > 4 ? std::atoll(argv[4]) : 10000000;
+    return runScenario(scenario, [&]() {
+      scenario.table() << "FrozenHashMap against HashMap" << std::endl;
+      perfomFrozenTests(scenario, maxElements);
+    });
+  }
+
+  if(noArguments > 3 && std::string(argv[3]) == "static")
+    return runScenario(scenario, [&]() {
+      scenario.table() << "StaticMap against HashMap for a fixed table" << std::endl;
+      perfomStaticMapTests(scenario);
+    });
+
+  if(noArguments > 3 && std::string(argv[3]) == "groupprobe") {
+    const std::size_t noSlots = noArguments > 4 ? std::atoll(argv[4]) : 1 << 20;
+    return runScenario(scenario, [&]() {
+      scenario.table() << "FlatHashMap group probing against HashMap chains at " << noSlots << " slots" << std::endl;
+      perfomGroupProbeTests(scenario, noSlots);
+    });
+  }
+
+  if(noArguments > 3 && std::string(argv[3]) == "churn") {
+    const std::size_t noElements = noArguments > 4 ? std::atoll(argv[4]) : 1000000;
+    const std::size_t noRounds = noArguments > 5 ? std::atoll(argv[5]) : 20;
+    return runScenario(scenario, [&]() {
+      scenario.table() << "FlatHashMap of " << noElements << " keys under insert/remove churn" << std::endl;
+      perfomChurnTests(scenario, noElements, noRounds);
+    });
+  }
+
+  if(noArguments > 3 && std::string(argv[3]) == "sumvalues") {
+    const std::size_t noElements = noArguments > 4 ? std::atoll(argv[4]) : 10000000;
+    return runScenario(scenario, [&]() {
+      scenario.table() << "Sum of the values of " << noElements << " entries" << std::endl;
+      perfomSumValuesTests(scenario, noElements);
+    });
+  }
+  scenario.options.maps = { argv[2] };
+  try {
+    return runHarness(scenario.options);
+  } catch(const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    printUsage(std::cerr);
+    return 1;
   }
-  return 0;
 }
@@ -0,0 +1,197 @@
+#include <AdaptiveMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <utility>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::AdaptiveMap<K, std::string, 4>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(AdaptiveMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  for (const auto& item : expected)
+  {
+    const auto it = map.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_MESSAGE(it->second == item.second,
+                        "Wrong value in map for key: " << item.first
+                        << " (expected: \"" << item.second
+                        << "\" got: \"" << it->second << "\")");
+  }
+
+  std::size_t iterated = 0;
+  for (auto it = map.begin(); it != map.end(); ++it, ++iterated)
+    BOOST_CHECK(expected.count(it->first) == 1);
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+}
+
+template <typename K>
+std::map<K, std::string> fillMap(Map<K>& map, int count)
+{
+  std::map<K, std::string> expected;
+  for (int i = 0; i < count; i++) {
+    map[i * 10] = std::to_string(i);
+    expected[i * 10] = std::to_string(i);
+  }
+  return expected;
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmptyAndInline,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.isInline());
+  BOOST_CHECK(map.cbegin() == map.cend());
+  BOOST_CHECK_EQUAL(map.memoryUsage().allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithFewItems_WhenLookingThemUp_ThenTheyAreFoundInline,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map[27] = "Chuck";
+
+  BOOST_CHECK(map.isInline());
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Chuck" } });
+  BOOST_CHECK(map.tryGet(13) == nullptr);
+  BOOST_CHECK_THROW(map.valueOf(13), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFullInlineMap_WhenAddingItem_ThenItIsPromotedToTable,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  auto expected = fillMap(map, 4);
+  BOOST_CHECK(map.isInline());
+
+  map[1410] = "Grunwald";
+  expected[1410] = "Grunwald";
+
+  BOOST_CHECK(!map.isInline());
+  BOOST_CHECK_GT(map.memoryUsage().allocations, 0);
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenPromotedMap_WhenRemovingItems_ThenItIsDemotedAtHalfOfCapacity,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  auto expected = fillMap(map, 6);
+
+  for (int i = 0; i < 3; i++) {
+    map.remove(i * 10);
+    expected.erase(i * 10);
+  }
+  BOOST_CHECK(!map.isInline());
+  map.remove(30);
+  expected.erase(30);
+
+  BOOST_CHECK(map.isInline());
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenInlineMap_WhenRemovingItems_ThenRestIsFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  map.remove(42);
+  map.remove(map.find(13));
+
+  thenMapContainsItems(map, { { 27, "Bob" } });
+  BOOST_CHECK_THROW(map.remove(42), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenRemovingItem_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK_THROW(map.remove(42), std::out_of_range);
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapInEitherRepresentation_WhenIteratingBothWays_ThenEveryItemIsVisited,
+                              K,
+                              TestedKeyTypes)
+{
+  for (int size : { 3, 20 }) {
+    Map<K> map;
+    fillMap(map, size);
+
+    int forward = 0, backward = 0;
+    for (auto it = map.begin(); it != map.end(); ++it)
+      forward++;
+    for (auto it = map.end(); it != map.begin(); --it)
+      backward++;
+
+    BOOST_CHECK_EQUAL(forward, size);
+    BOOST_CHECK_EQUAL(backward, size);
+    BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+    BOOST_CHECK_THROW(map.begin()--, std::out_of_range);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenAssigningThroughIt_ThenValueIsChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  auto expected = fillMap(map, 10);
+
+  map.find(50)->second = "five";
+  expected[50] = "five";
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapInEitherRepresentation_WhenCopyingAndMoving_ThenItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  for (int size : { 3, 20 }) {
+    Map<K> map;
+    const auto expected = fillMap(map, size);
+
+    Map<K> copy(map);
+    Map<K> moved(std::move(map));
+    Map<K> assigned;
+    assigned = copy;
+
+    thenMapContainsItems(copy, expected);
+    thenMapContainsItems(moved, expected);
+    thenMapContainsItems(assigned, expected);
+    BOOST_CHECK(map.isEmpty());
+    BOOST_CHECK(copy == moved);
+    copy[999] = "";
+    BOOST_CHECK(copy != moved);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,355 @@
+#include <CuckooHashMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::CuckooHashMap<K, std::string>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(CuckooHashMapTests)
+
+template <typename K, typename M>
+void thenMapContainsItems(const M& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  for (const auto& item : expected)
+  {
+    const auto it = map.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_MESSAGE(it->second == item.second,
+                        "Wrong value in map for key: " << item.first
+                        << " (expected: \"" << item.second
+                        << "\" got: \"" << it->second << "\")");
+  }
+
+  std::size_t iterated = 0;
+  for (auto it = map.begin(); it != map.end(); ++it, ++iterated)
+    BOOST_CHECK(expected.count(it->first) == 1);
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+  BOOST_CHECK(map.find(42) == map.end());
+  BOOST_CHECK(map.tryGet(42) == nullptr);
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItems_ThenTheyAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map[1410] = "Grunwald";
+  map[27] = "Chuck";
+
+  thenMapContainsItems<K>(map, { { 42, "Alice" }, { 27, "Chuck" }, { 1410, "Grunwald" } });
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
+  BOOST_CHECK_EQUAL(*map.tryGet(1410), "Grunwald");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyItems_WhenAddingThem_ThenTableGrowsAndAllAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  std::map<K, std::string> expected;
+  Map<K> map;
+
+  for (K key = 0; key < 20000; ++key)
+  {
+    const K stridedKey = key * 4096;
+    map[stridedKey] = std::to_string(key);
+    expected[stridedKey] = std::to_string(key);
+  }
+
+  thenMapContainsItems<K>(map, expected);
+  BOOST_CHECK(map.find(1) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenRemovingThem_ThenOnlyOthersRemain,
+                              K,
+                              TestedKeyTypes)
+{
+  std::map<K, std::string> expected;
+  Map<K> map;
+  for (K key = 0; key < 1000; ++key)
+  {
+    map[key] = std::to_string(key);
+    expected[key] = std::to_string(key);
+  }
+
+  for (K key = 0; key < 1000; key += 3)
+  {
+    map.remove(key);
+    expected.erase(key);
+  }
+  map.remove(map.find(1));
+  expected.erase(1);
+
+  thenMapContainsItems<K>(map, expected);
+  BOOST_CHECK_THROW(map.remove(0), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingAndRemovingRandomly_ThenItMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  std::mt19937 generator(1410);
+  std::uniform_int_distribution<int> keys(0, 3000);
+  std::map<K, std::string> expected;
+  Map<K> map;
+
+  for (int i = 0; i < 50000; ++i)
+  {
+    const K key = keys(generator);
+    if (expected.count(key) == 1 && i % 2 == 0)
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems<K>(map, expected);
+}
+
+template <typename K>
+struct ConstantHash
+{
+  std::size_t operator()(const K&) const
+  {
+    return 7;
+  }
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHash_WhenBucketsAreFull_ThenItemsGoToStash,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::CuckooHashMap<K, std::string, ConstantHash<K>> map;
+  std::map<K, std::string> expected;
+  // every key has the same two buckets - or just one, when the seed makes them equal
+  const K capacity = Map<K>::SLOTS + Map<K>::STASH_SIZE;
+
+  for (K key = 0; key < capacity; ++key)
+  {
+    map[key] = std::to_string(key);
+    expected[key] = std::to_string(key);
+  }
+
+  BOOST_CHECK(map.stashSize() >= Map<K>::STASH_SIZE - Map<K>::SLOTS);
+  thenMapContainsItems<K>(map, expected);
+
+  for (K key = 0; key < capacity; key += 2)
+  {
+    map.remove(key);
+    expected.erase(key);
+  }
+
+  thenMapContainsItems<K>(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHash_WhenStashIsFull_ThenAddingThrowsAndStashStaysBounded,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::CuckooHashMap<K, std::string, ConstantHash<K>> map;
+  std::map<K, std::string> expected;
+  K key = 0;
+
+  BOOST_CHECK_THROW(
+    for ( ; key < 100; ++key)
+    {
+      map[key] = std::to_string(key);
+      expected[key] = std::to_string(key);
+    },
+    std::length_error);
+
+  BOOST_CHECK(map.stashSize() == Map<K>::STASH_SIZE);
+  BOOST_CHECK(map.getSize() <= 2 * Map<K>::SLOTS + Map<K>::STASH_SIZE);
+  BOOST_CHECK(map.find(key) == map.end());
+  thenMapContainsItems<K>(map, expected);
+}
+
+// a value whose move constructor throws once movesLeft reaches zero, negative - never
+struct FragileMove
+{
+  static int movesLeft;
+  std::string text;
+
+  FragileMove() = default;
+  FragileMove(const FragileMove&) = default;
+  FragileMove& operator=(const FragileMove&) = default;
+  FragileMove& operator=(FragileMove&&) = default;
+
+  FragileMove(FragileMove&& other)
+  {
+    if (movesLeft == 0)
+      throw std::runtime_error("cannot move");
+    movesLeft--;
+    text = std::move(other.text);
+  }
+};
+
+int FragileMove::movesLeft = -1;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenGrowingThrows_ThenItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::CuckooHashMap<K, FragileMove> map;
+  const std::size_t initialBucketBytes = map.memoryUsage().heapBytes;
+  K key = 0;
+  bool thrown = false;
+
+  // an insertion moves a few entries at most, growing moves all of them
+  for ( ; !thrown && key < 10000; ++key)
+  {
+    FragileMove::movesLeft = 20;
+    try {
+      map[key].text = std::to_string(key);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+  }
+  FragileMove::movesLeft = -1;
+  --key;
+
+  BOOST_REQUIRE(thrown);
+  BOOST_CHECK(map.memoryUsage().heapBytes > initialBucketBytes);
+  BOOST_CHECK_EQUAL(map.getSize(), static_cast<std::size_t>(key));
+  BOOST_CHECK(map.find(key) == map.end());
+  std::size_t iterated = 0;
+  for (const auto& item : map)
+  {
+    BOOST_CHECK_EQUAL(item.second.text, std::to_string(item.first));
+    iterated++;
+  }
+  BOOST_CHECK_EQUAL(iterated, map.getSize());
+  for (K present = 0; present < key; ++present)
+    BOOST_CHECK(map.find(present) != map.end());
+  map[key].text = std::to_string(key);
+  BOOST_CHECK_EQUAL(map.valueOf(key).text, std::to_string(key));
+}
+
+BOOST_AUTO_TEST_CASE(GivenSmallEntries_WhenLaidOutInBuckets_ThenBucketIsOneCacheLine)
+{
+  using NumberMap = aisdi::CuckooHashMap<std::int32_t, long>;
+  using IntMap = aisdi::CuckooHashMap<std::int32_t, std::int32_t>;
+
+  BOOST_CHECK_EQUAL(NumberMap::bucketBytes(), aisdi::CACHE_LINE);
+  BOOST_CHECK(NumberMap::SLOTS == 3);
+  BOOST_CHECK(IntMap::SLOTS == 4);
+  BOOST_CHECK(Map<std::int32_t>::SLOTS == 2);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenMovingIteratorsBothWays_ThenAllItemsAreVisited,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  std::size_t visited = 0;
+  for (auto it = map.end(); it != map.begin(); --it)
+    ++visited;
+
+  BOOST_CHECK_EQUAL(visited, 3);
+  BOOST_CHECK_THROW(--map.begin(), std::out_of_range);
+  BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenChangingValueThroughIterator_ThenValueIsChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+
+  map.begin()->second = "Bob";
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Bob");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenCopyingMovingAndAssigning_ThenMapsAreEqual,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K key = 0; key < 500; ++key)
+    map[key] = std::to_string(key);
+
+  const Map<K> copy(map);
+  Map<K> assigned;
+  assigned = map;
+  const Map<K> moved(std::move(map));
+
+  BOOST_CHECK(copy == moved);
+  BOOST_CHECK(assigned == moved);
+  BOOST_CHECK(map.isEmpty());
+
+  assigned[0] = "changed";
+  BOOST_CHECK(assigned != copy);
+  BOOST_CHECK_EQUAL(copy.valueOf(0), "0");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHash_WhenCopying_ThenStashIsCopied,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::CuckooHashMap<K, std::string, ConstantHash<K>> map;
+  const K capacity = Map<K>::SLOTS + Map<K>::STASH_SIZE;
+  for (K key = 0; key < capacity; ++key)
+    map[key] = std::to_string(key);
+
+  const auto copy = map;
+
+  BOOST_CHECK(copy == map);
+  BOOST_CHECK_EQUAL(copy.stashSize(), map.stashSize());
+  BOOST_CHECK_EQUAL(copy.valueOf(0), "0");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenComputingMemoryUsage_ThenItIsTheBucketArray,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K key = 0; key < 1000; ++key)
+    map[key] = "";
+
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(usage.allocations, 1 + (map.stashSize() > 0 ? 1 + map.stashSize() : 0));
+  BOOST_CHECK_EQUAL(usage.payloadBytes, 1000 * sizeof(typename Map<K>::value_type));
+  // load above MAX_LOAD_PERCENT / 2 after the last growth
+  BOOST_CHECK_LT(usage.requestedBytes, 2.5 * usage.payloadBytes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
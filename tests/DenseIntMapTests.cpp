@@ -0,0 +1,234 @@
+#include <DenseIntMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::DenseIntMap<K, std::string, 2000>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(DenseIntMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  for (const auto& item : expected)
+  {
+    const auto it = map.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_MESSAGE(it->second == item.second,
+                        "Wrong value in map for key: " << item.first
+                        << " (expected: \"" << item.second
+                        << "\" got: \"" << it->second << "\")");
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItems_ThenTheyAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  map[42] = "Alice";
+  map[27] = "Bob";
+  map[1410] = "Grunwald";
+  map[27] = "Chuck";
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Chuck" }, { 1410, "Grunwald" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingKeysAtBothEndsOfRange_ThenTheyAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  map[0] = "first";
+  map[1999] = "last";
+
+  thenMapContainsItems(map, { { 0, "first" }, { 1999, "last" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingKeyOutOfRange_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK_THROW(map[2000], std::out_of_range);
+  BOOST_CHECK_THROW(map[static_cast<K>(-1)], std::out_of_range);
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenLookingUpMissingKeys_ThenMissIsReported,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.find(13) == map.end());
+  BOOST_CHECK(map.find(2000) == map.end());
+  BOOST_CHECK(map.find(static_cast<K>(-1)) == map.end());
+  BOOST_CHECK(map.tryGet(100000) == nullptr);
+  BOOST_CHECK_THROW(map.valueOf(30), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(5000), std::out_of_range);
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenGettingValueOrRemoving_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(42), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+  BOOST_CHECK(map.tryGet(42) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenIterating_ThenKeysAreInAscendingOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 1410, "Grunwald" }, { 42, "Alice" }, { 63, "Bob" }, { 64, "Chuck" }, { 0, "Dan" },
+                       { 1999, "Eve" } };
+  const std::vector<K> expected = { 0, 42, 63, 64, 1410, 1999 };
+
+  std::vector<K> keys;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    keys.push_back(it->first);
+  std::vector<K> reversed;
+  for (auto it = map.end(); it != map.begin(); )
+    reversed.insert(reversed.begin(), (--it)->first);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(keys.begin(), keys.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(reversed.begin(), reversed.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenMovingIterators_ThenOperationsThrow,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+  BOOST_CHECK_THROW(--(map.begin()), std::out_of_range);
+  BOOST_CHECK_THROW(*map.cend(), std::out_of_range);
+  map[500] = "";
+  BOOST_CHECK_THROW(--(map.begin()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenAssigningThroughIt_ThenValueIsChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map.find(27)->second = "Chuck";
+  (*map.begin()).second += "!";
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Chuck!" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingItems_ThenRestIsFoundAndRemovedKeysAreMissing,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" }, { 1410, "Grunwald" } };
+
+  map.remove(27);
+  map.remove(map.find(1410));
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 13, "Chuck" } });
+  BOOST_CHECK(map.find(27) == map.end());
+  BOOST_CHECK_THROW(map.remove(27), std::out_of_range);
+  BOOST_CHECK_EQUAL(map[27], "");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyRandomKeys_WhenAddingAndRemoving_ThenResultsMatchStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  std::mt19937 generator(7);
+  std::map<K, std::string> expected;
+  Map<K> map;
+  for (int i = 0; i < 3000; i++) {
+    const K key = static_cast<K>(generator() % 2000);
+    if (i % 3 == 2 && expected.count(key) == 1) {
+      expected.erase(key);
+      map.remove(key);
+    } else {
+      expected[key] = std::to_string(i);
+      map[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+  auto expectedIt = expected.begin();
+  for (auto it = map.begin(); it != map.end(); ++it, ++expectedIt)
+    BOOST_CHECK_EQUAL(it->first, expectedIt->first);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCopyingAndMoving_ThenItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  Map<K> copy(map);
+  Map<K> moved(std::move(map));
+  Map<K> assigned;
+  assigned = copy;
+
+  thenMapContainsItems(copy, { { 42, "Alice" }, { 27, "Bob" } });
+  BOOST_CHECK(moved == copy);
+  BOOST_CHECK(assigned == copy);
+  BOOST_CHECK(map.isEmpty());
+  map[5] = "";
+  copy[27] = "Chuck";
+  BOOST_CHECK(copy != moved);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingItems_ThenMemoryUsageIsWholeRange,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const auto empty = map.memoryUsage();
+
+  map[1] = "one";
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(empty.allocations, 2);
+  BOOST_CHECK_EQUAL(usage.requestedBytes, empty.requestedBytes);
+  BOOST_CHECK_GE(usage.requestedBytes, 2000 * sizeof(std::string) + 2000 / 8);
+  BOOST_CHECK_EQUAL(usage.payloadBytes, sizeof(typename Map<K>::value_type));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
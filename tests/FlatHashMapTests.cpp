@@ -0,0 +1,351 @@
+#include <FlatHashMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::FlatHashMap<K, std::string>;
+
+template <typename K>
+using ScalarMap = aisdi::FlatHashMap<K, std::string, aisdi::Hash<K>, aisdi::EqualTo<K>, aisdi::ScalarGroup>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(FlatHashMapTests)
+
+template <typename K, typename M>
+void thenMapContainsItems(const M& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  for (const auto& item : expected)
+  {
+    const auto it = map.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_MESSAGE(it->second == item.second,
+                        "Wrong value in map for key: " << item.first
+                        << " (expected: \"" << item.second
+                        << "\" got: \"" << it->second << "\")");
+  }
+
+  std::size_t iterated = 0;
+  for (auto it = map.begin(); it != map.end(); ++it, ++iterated)
+    BOOST_CHECK(expected.count(it->first) == 1);
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+  BOOST_CHECK(map.find(42) == map.end());
+  BOOST_CHECK(map.tryGet(42) == nullptr);
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItems_ThenTheyAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map[1410] = "Grunwald";
+  map[27] = "Chuck";
+
+  thenMapContainsItems<K>(map, { { 42, "Alice" }, { 27, "Chuck" }, { 1410, "Grunwald" } });
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
+  BOOST_CHECK_EQUAL(*map.tryGet(1410), "Grunwald");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyItems_WhenAddingThem_ThenTableGrowsAndAllAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  std::map<K, std::string> expected;
+  Map<K> map;
+
+  for (K key = 0; key < 20000; ++key)
+  {
+    const K stridedKey = key * 4096;
+    map[stridedKey] = std::to_string(key);
+    expected[stridedKey] = std::to_string(key);
+  }
+
+  thenMapContainsItems<K>(map, expected);
+  BOOST_CHECK(map.find(1) == map.end());
+  BOOST_CHECK_LE(map.loadFactor(), Map<K>::MAX_LOAD_PER_MILLE / 1000.0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenRemovingThem_ThenOnlyOthersRemain,
+                              K,
+                              TestedKeyTypes)
+{
+  std::map<K, std::string> expected;
+  Map<K> map;
+  for (K key = 0; key < 1000; ++key)
+  {
+    map[key] = std::to_string(key);
+    expected[key] = std::to_string(key);
+  }
+
+  for (K key = 0; key < 1000; key += 3)
+  {
+    map.remove(key);
+    expected.erase(key);
+  }
+  map.remove(map.find(1));
+  expected.erase(1);
+
+  thenMapContainsItems<K>(map, expected);
+  BOOST_CHECK_THROW(map.remove(0), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingAndRemovingRandomly_ThenItMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  std::mt19937 generator(1410);
+  std::uniform_int_distribution<int> keys(0, 3000);
+  std::map<K, std::string> expected;
+  Map<K> map;
+
+  for (int i = 0; i < 50000; ++i)
+  {
+    const K key = keys(generator);
+    if (expected.count(key) == 1 && i % 2 == 0)
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems<K>(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenScalarGroupMap_WhenInsertingAndRemovingRandomly_ThenItMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  std::mt19937 generator(1410);
+  std::uniform_int_distribution<int> keys(0, 3000);
+  std::map<K, std::string> expected;
+  ScalarMap<K> map;
+
+  for (int i = 0; i < 50000; ++i)
+  {
+    const K key = keys(generator);
+    if (expected.count(key) == 1 && i % 2 == 0)
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems<K>(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRandomControlBytes_WhenMatchingGroups_ThenKernelsAgreeWithBytewiseLoop)
+{
+  std::mt19937 generator(27);
+  const std::int8_t markers[] = { aisdi::control::EMPTY, 0, 1, 5, 0x7e, 0x7f };
+  std::uniform_int_distribution<int> pick(0, sizeof(markers) - 1);
+
+  for (int round = 0; round < 1000; ++round)
+  {
+    std::int8_t bytes[16];
+    for (auto& byte : bytes)
+      byte = markers[pick(generator)];
+
+    const aisdi::ScalarGroup scalar(bytes);
+    const aisdi::DefaultGroup group(bytes);
+    for (const std::int8_t fingerprint : { 0, 1, 5, 0x7f })
+    {
+      aisdi::GroupMask expected = 0;
+      for (int i = 0; i < 16; ++i)
+        expected |= (bytes[i] == fingerprint ? 1u : 0u) << i;
+      BOOST_CHECK_EQUAL(scalar.match(fingerprint), expected);
+      BOOST_CHECK_EQUAL(group.match(fingerprint), expected);
+    }
+
+    aisdi::GroupMask empty = 0;
+    for (int i = 0; i < 16; ++i)
+      empty |= (bytes[i] == aisdi::control::EMPTY ? 1u : 0u) << i;
+    BOOST_CHECK_EQUAL(scalar.matchEmpty(), empty);
+    BOOST_CHECK_EQUAL(group.matchEmpty(), empty);
+  }
+}
+
+template <typename K>
+struct ConstantHash
+{
+  std::size_t operator()(const K&) const
+  {
+    return 7;
+  }
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHash_WhenAddingAndRemovingItems_ThenItemsAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::FlatHashMap<K, std::string, ConstantHash<K>> map;
+  std::map<K, std::string> expected;
+
+  for (K key = 0; key < 100; ++key)
+  {
+    map[key] = std::to_string(key);
+    expected[key] = std::to_string(key);
+  }
+  for (K key = 0; key < 100; key += 2)
+  {
+    map.remove(key);
+    expected.erase(key);
+  }
+  map[1000] = "1000";
+  expected[1000] = "1000";
+
+  thenMapContainsItems<K>(map, expected);
+  BOOST_CHECK(map.find(2) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFullTable_WhenReplacingItemsManyTimes_ThenItNeitherGrowsNorSlowsDown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::vector<K> keys;
+  for (K key = 0; key < 850; ++key)
+  {
+    map[key] = "";
+    keys.push_back(key);
+  }
+  const auto capacity = map.capacity();
+  const double probeLength = map.averageProbeLength();
+
+  std::mt19937 generator(1410);
+  for (K key = 1000; key < 101000; ++key)
+  {
+    K& victim = keys[generator() % keys.size()];
+    map.remove(victim);
+    victim = key;
+    map[victim] = "";
+  }
+
+  BOOST_CHECK_EQUAL(map.capacity(), capacity);
+  BOOST_CHECK_LT(map.averageProbeLength(), 2 * probeLength + 1);
+  std::map<K, std::string> expected;
+  for (const auto key : keys)
+    expected[key] = "";
+  thenMapContainsItems<K>(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenVisitingChunks_ThenTheyHoldAllItemsInIterationOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K key = 0; key < 1000; ++key)
+    map[key * 7] = std::to_string(key);
+  map.remove(14);
+
+  std::vector<const typename Map<K>::value_type*> visited;
+  std::size_t chunks = 0;
+  map.forEachChunk([&](const auto chunk) {
+    BOOST_CHECK(!chunk.empty());
+    BOOST_CHECK(chunk.size() <= Map<K>::CHUNK_SIZE);
+    visited.insert(visited.end(), chunk.begin(), chunk.end());
+    ++chunks;
+  });
+
+  std::vector<const typename Map<K>::value_type*> iterated;
+  for (const auto& item : map)
+    iterated.push_back(&item);
+  BOOST_CHECK(visited == iterated);
+  BOOST_CHECK_EQUAL(chunks, (map.getSize() + Map<K>::CHUNK_SIZE - 1) / Map<K>::CHUNK_SIZE);
+  Map<K>().forEachChunk([](auto) { BOOST_ERROR("empty map has no chunks"); });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenMovingIteratorsBothWays_ThenAllItemsAreVisited,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  std::size_t visited = 0;
+  for (auto it = map.end(); it != map.begin(); --it)
+    ++visited;
+
+  BOOST_CHECK_EQUAL(visited, 3);
+  BOOST_CHECK_THROW(--map.begin(), std::out_of_range);
+  BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenCopyingMovingAndAssigning_ThenMapsAreEqual,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K key = 0; key < 500; ++key)
+    map[key] = std::to_string(key);
+  map.remove(7);
+
+  const Map<K> copy(map);
+  Map<K> assigned;
+  assigned = map;
+  const Map<K> moved(std::move(map));
+
+  BOOST_CHECK(copy == moved);
+  BOOST_CHECK(assigned == moved);
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(copy.find(7) == copy.end());
+
+  assigned[0] = "changed";
+  BOOST_CHECK(assigned != copy);
+  BOOST_CHECK_EQUAL(copy.valueOf(0), "0");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenComputingMemoryUsage_ThenItIsSlotsAndControlBytes,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K key = 0; key < 1000; ++key)
+    map[key] = "";
+
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(usage.allocations, 2);
+  BOOST_CHECK_EQUAL(usage.payloadBytes, 1000 * sizeof(typename Map<K>::value_type));
+  BOOST_CHECK_EQUAL(usage.requestedBytes,
+                    map.capacity() * (sizeof(typename Map<K>::value_type) + 1) + 15);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
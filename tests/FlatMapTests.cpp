@@ -0,0 +1,289 @@
+#include <FlatMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::FlatMap<K, std::string>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(FlatMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  for (const auto& item : expected)
+  {
+    const auto it = map.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_MESSAGE(it->second == item.second,
+                        "Wrong value in map for key: " << item.first
+                        << " (expected: \"" << item.second
+                        << "\" got: \"" << it->second << "\")");
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItems_ThenTheyAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  map[42] = "Alice";
+  map[27] = "Bob";
+  map[1410] = "Grunwald";
+  map[27] = "Chuck";
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Chuck" }, { 1410, "Grunwald" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenIterating_ThenKeysAreInAscendingOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 1410, "Grunwald" }, { 13, "Chuck" } };
+  const std::vector<K> expected = { 13, 27, 42, 1410 };
+
+  std::vector<K> keys;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    keys.push_back(it->first);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(keys.begin(), keys.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenDecrementingEnd_ThenLastItemIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  auto it = map.end();
+  --it;
+
+  BOOST_CHECK_EQUAL(it->first, 42);
+  BOOST_CHECK_EQUAL((*it).second, "Alice");
+  BOOST_CHECK(--it == map.begin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenMovingIterators_ThenOperationsThrow,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+  BOOST_CHECK_THROW(--(map.begin()), std::out_of_range);
+  BOOST_CHECK_THROW(*map.cend(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenAssigningThroughIt_ThenValueIsChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map.find(27)->second = "Chuck";
+  (*map.begin()).second += "!";
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Chuck!" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenLookingUpMissingKey_ThenMissIsReported,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.find(13) == map.end());
+  BOOST_CHECK(map.find(1410) == map.end());
+  BOOST_CHECK(map.tryGet(30) == nullptr);
+  BOOST_CHECK_THROW(map.valueOf(30), std::out_of_range);
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenGettingValue_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+  BOOST_CHECK(map.tryGet(42) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingItems_ThenRestIsFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" }, { 1410, "Grunwald" } };
+
+  map.remove(27);
+  map.remove(map.find(1410));
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 13, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingMissingItem_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK_THROW(map.remove(42), std::out_of_range);
+  map[42] = "Alice";
+  BOOST_CHECK_THROW(map.remove(27), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingBatch_ThenItIsMergedAndLaterValuesWin,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 100, "Dan" } };
+  const std::vector<std::pair<K, std::string>> batch = {
+    { 13, "Chuck" }, { 42, "Eve" }, { 1410, "Grunwald" }, { 13, "Frank" }, { 5, "Gina" } };
+
+  map.insert(batch.begin(), batch.end());
+
+  thenMapContainsItems(map, { { 5, "Gina" }, { 13, "Frank" }, { 27, "Bob" }, { 42, "Eve" },
+                              { 100, "Dan" }, { 1410, "Grunwald" } });
+  std::vector<K> keys;
+  for (const auto item : map)
+    keys.push_back(item.first);
+  const std::vector<K> expected = { 5, 13, 27, 42, 100, 1410 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(keys.begin(), keys.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyRandomKeys_WhenLookingThemUp_ThenResultsMatchStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  std::mt19937 generator(7);
+  std::map<K, std::string> expected;
+  Map<K> map;
+  for (int i = 0; i < 1000; i++) {
+    const K key = static_cast<K>(generator() % 2000);
+    expected[key] = std::to_string(i);
+    map[key] = std::to_string(i);
+  }
+
+  thenMapContainsItems(map, expected);
+  for (int key = 0; key < 2000; key++)
+    BOOST_CHECK_EQUAL(map.tryGet(static_cast<K>(key)) != nullptr, expected.count(static_cast<K>(key)) == 1);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithSameItems_WhenComparing_ThenTheyAreEqual,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map<K> other = { { 27, "Bob" }, { 42, "Alice" } };
+
+  BOOST_CHECK(map == other);
+  map[27] = "Chuck";
+  BOOST_CHECK(map != other);
+}
+
+struct FragileValue
+{
+  static bool failing;
+  int number = 0;
+
+  FragileValue()
+  {
+    if (failing)
+      throw std::runtime_error("cannot construct");
+  }
+};
+
+bool FragileValue::failing = false;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingItemThrows_ThenKeysAndValuesStayPaired,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::FlatMap<K, FragileValue> map;
+  for (K key = 0; key < 200; key += 2)
+    map[key].number = static_cast<int>(key);
+
+  FragileValue::failing = true;
+  BOOST_CHECK_THROW(map[51], std::runtime_error);
+  FragileValue::failing = false;
+
+  BOOST_CHECK_EQUAL(map.getSize(), 100);
+  BOOST_CHECK(map.find(51) == map.end());
+  for (const auto& item : map)
+    BOOST_CHECK_EQUAL(item.second.number, static_cast<int>(item.first));
+  map[51].number = 51;
+  BOOST_CHECK_EQUAL(map.valueOf(51).number, 51);
+  BOOST_CHECK_EQUAL(map.valueOf(52).number, 52);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingItems_ThenMemoryUsageIsTwoArrays,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const auto empty = map.memoryUsage();
+
+  map[1] = "one";
+  map[2] = "two";
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(empty.allocations, 0);
+  BOOST_CHECK_EQUAL(usage.allocations, 2);
+  BOOST_CHECK_EQUAL(usage.payloadBytes, 2 * sizeof(typename Map<K>::value_type));
+  BOOST_CHECK_GE(usage.requestedBytes, 2 * (sizeof(K) + sizeof(std::string)));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenVisitingChunks_ThenKeysAndValuesArePassedOnceInIterationOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  std::size_t chunks = 0;
+  map.forEachChunk([&](const auto keys, const auto values) {
+    BOOST_REQUIRE_EQUAL(keys.size(), map.getSize());
+    BOOST_REQUIRE_EQUAL(values.size(), map.getSize());
+    std::size_t position = 0;
+    for (auto it = map.begin(); it != map.end(); ++it, ++position)
+    {
+      BOOST_CHECK_EQUAL(keys[position], it->first);
+      BOOST_CHECK_EQUAL(values[position], it->second);
+    }
+    ++chunks;
+  });
+
+  BOOST_CHECK_EQUAL(chunks, 1);
+  Map<K>().forEachChunk([](auto, auto) { BOOST_ERROR("empty map has no chunks"); });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,238 @@
+#include <FrozenHashMap.h>
+#include <HashMap.h>
+#include <TreeMap.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::FrozenHashMap<K, std::string>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(FrozenHashMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  for (const auto& item : expected)
+  {
+    const auto it = map.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_MESSAGE(it->second == item.second,
+                        "Wrong value in map for key: " << item.first
+                        << " (expected: \"" << item.second
+                        << "\" got: \"" << it->second << "\")");
+  }
+
+  std::size_t iterated = 0;
+  for (auto it = map.begin(); it != map.end(); ++it, ++iterated)
+    BOOST_CHECK(expected.count(it->first) == 1);
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+  BOOST_CHECK(map.find(42) == map.end());
+  BOOST_CHECK(map.tryGet(42) == nullptr);
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+  BOOST_CHECK_EQUAL(map.memoryUsage().allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyRange_WhenBuildingMap_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const std::vector<std::pair<K, std::string>> items;
+
+  const auto map = Map<K>::build(items);
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.find(0) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenHashMap_WhenBuildingMap_ThenAllItemsAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string> source = { { 42, "Alice" }, { 27, "Bob" }, { 1410, "Grunwald" } };
+
+  const auto map = Map<K>::build(source);
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Bob" }, { 1410, "Grunwald" } });
+  BOOST_CHECK_EQUAL(map.valueOf(1410), "Grunwald");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTreeMapOrIteratorRange_WhenBuildingMap_ThenAllItemsAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, std::string> tree = { { 42, "Alice" }, { 27, "Bob" } };
+  const std::vector<std::pair<K, std::string>> items = { { 13, "Chuck" }, { 7, "Dan" }, { 99, "Eve" } };
+
+  const auto fromTree = Map<K>::build(tree);
+  const auto fromRange = Map<K>::build(items.begin() + 1, items.end());
+
+  thenMapContainsItems(fromTree, { { 42, "Alice" }, { 27, "Bob" } });
+  thenMapContainsItems(fromRange, { { 7, "Dan" }, { 99, "Eve" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBuiltMap_WhenLookingUpMissingKeys_ThenMissIsReported,
+                              K,
+                              TestedKeyTypes)
+{
+  std::vector<std::pair<K, std::string>> items;
+  for (K key = 0; key < 1000; ++key)
+    items.emplace_back(2 * key, std::to_string(key));
+
+  const auto map = Map<K>::build(items);
+
+  for (K key = 0; key < 1000; ++key)
+  {
+    BOOST_CHECK(map.find(2 * key + 1) == map.end());
+    BOOST_CHECK(map.tryGet(2 * key + 1) == nullptr);
+  }
+  BOOST_CHECK_THROW(map.valueOf(1), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyKeys_WhenBuildingMap_ThenEveryKeyIsInItsOwnSlot,
+                              K,
+                              TestedKeyTypes)
+{
+  std::map<K, std::string> expected;
+  std::vector<std::pair<K, std::string>> items;
+  for (K key = 0; key < 20000; ++key)
+  {
+    const K stridedKey = key * 4096;
+    expected[stridedKey] = std::to_string(key);
+    items.emplace_back(stridedKey, std::to_string(key));
+  }
+
+  const auto map = Map<K>::build(items);
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRangeWithRepeatedKey_WhenBuildingMap_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  const std::vector<std::pair<K, std::string>> items = { { 42, "Alice" }, { 27, "Bob" }, { 42, "Chuck" } };
+
+  BOOST_CHECK_THROW(Map<K>::build(items), std::invalid_argument);
+}
+
+// keeps the low 16 bits only - keys 65536 apart have the same hash whatever the seed
+struct TruncatingHash
+{
+  std::size_t operator()(int key) const
+  {
+    return static_cast<std::uint16_t>(key);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(GivenKeysWithEqualHashes_WhenBuildingMap_ThenAllAreFound)
+{
+  using TruncatingMap = aisdi::FrozenHashMap<int, long, TruncatingHash>;
+  const std::vector<std::pair<int, long>> pair = { { 0, 1 }, { 65536, 2 } };
+  std::vector<std::pair<int, long>> items;
+  for (int key = 0; key < 1000; ++key)
+    items.emplace_back(key * 4096, key);
+
+  const auto small = TruncatingMap::build(pair);
+  const auto map = TruncatingMap::build(items);
+
+  BOOST_CHECK_EQUAL(small.valueOf(0), 1);
+  BOOST_CHECK_EQUAL(small.valueOf(65536), 2);
+  BOOST_CHECK(small.find(131072) == small.end());
+  BOOST_CHECK_EQUAL(map.getSize(), 1000);
+  for (int key = 0; key < 1000; ++key)
+    BOOST_CHECK_EQUAL(map.valueOf(key * 4096), key);
+  BOOST_CHECK(map.tryGet(4096 * 1000) == nullptr);
+  BOOST_CHECK_THROW(TruncatingMap::build(std::vector<std::pair<int, long>>{ { 0, 1 }, { 65536, 2 }, { 0, 3 } }),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBuiltMap_WhenMovingIterators_ThenEndsThrow,
+                              K,
+                              TestedKeyTypes)
+{
+  const std::vector<std::pair<K, std::string>> items = { { 42, "Alice" }, { 27, "Bob" } };
+  const auto map = Map<K>::build(items);
+
+  auto it = map.end();
+  --it;
+  --it;
+
+  BOOST_CHECK(it == map.begin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+  BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBuiltMap_WhenCopyingAndAssigning_ThenMapsAreEqual,
+                              K,
+                              TestedKeyTypes)
+{
+  const std::vector<std::pair<K, std::string>> items = { { 42, "Alice" }, { 27, "Bob" } };
+  const std::vector<std::pair<K, std::string>> otherItems = { { 42, "Alice" }, { 27, "Chuck" } };
+  auto map = Map<K>::build(items);
+
+  const Map<K> copy(map);
+  Map<K> assigned;
+  assigned = map;
+  const Map<K> moved(std::move(map));
+
+  BOOST_CHECK(copy == moved);
+  BOOST_CHECK(assigned == moved);
+  BOOST_CHECK(Map<K>::build(otherItems) != moved);
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBuiltMap_WhenComputingMemoryUsage_ThenItIsThreeArrays,
+                              K,
+                              TestedKeyTypes)
+{
+  std::vector<std::pair<K, std::string>> items;
+  for (K key = 0; key < 1000; ++key)
+    items.emplace_back(key, "");
+
+  const auto map = Map<K>::build(items);
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(usage.allocations, 3);
+  BOOST_CHECK_EQUAL(usage.payloadBytes, 1000 * sizeof(typename Map<K>::value_type));
+  BOOST_CHECK_LT(usage.requestedBytes, usage.payloadBytes + 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapWithStringKeys_WhenSearchingByStringView_ThenItemIsReturned)
+{
+  const std::vector<std::pair<std::string, int>> items = { { "Alice", 42 }, { "Bob", 27 } };
+  const auto map = aisdi::FrozenHashMap<std::string, int>::build(items);
+
+  BOOST_CHECK_EQUAL(*map.tryGet(std::string_view("Alice")), 42);
+  BOOST_CHECK_EQUAL(map.find("Bob")->second, 27);
+  BOOST_CHECK(map.find(std::string_view("Chuck")) == map.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,13 @@
 #include <HashMap.h>
+#include <InterleavedLookup.h>
 
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <map>
+#include <stdexcept>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -470,6 +475,108 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValueOfAKey_ThenValue
   thenMapContainsItems(map, { { 42, "Chuck" }, { 27, "Bob" } });
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenTryingToGetAnyKey_ThenNullIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.tryGet(1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenTryingToGetMissingKey_ThenNullIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.tryGet(1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenTryingToGetAKey_ThenValueIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  const std::string* value = map.tryGet(27);
+
+  BOOST_REQUIRE(value != nullptr);
+  BOOST_CHECK_EQUAL(*value, "Bob");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValueThroughTryGet_ThenValueIsChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  *map.tryGet(42) = "Chuck";
+
+  thenMapContainsItems(map, { { 42, "Chuck" }, { 27, "Bob" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingItems_ThenMemoryUsageCountsOneNodeEach,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const auto empty = map.memoryUsage();
+
+  for (int i = 0; i < 10; i++)
+    map[i] = "";
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_GT(empty.allocations, 1); // the bucket array and the sentinel heads
+  BOOST_CHECK_EQUAL(empty.payloadBytes, 0);
+  BOOST_CHECK_EQUAL(usage.allocations, empty.allocations + 10);
+  BOOST_CHECK_EQUAL(usage.payloadBytes, 10 * sizeof(typename Map<K>::value_type));
+  BOOST_CHECK_GE(usage.heapBytes, usage.requestedBytes);
+  BOOST_CHECK_GT(usage.overheadBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapCountingStats_WhenAddingFindingAndRemovingItems_ThenEveryLookupIsCounted,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, aisdi::Hash<K>, aisdi::EqualTo<K>, false, aisdi::CountingStats> map;
+
+  for (int i = 0; i < 100; i++)
+    map[i] = "";
+  for (int i = 0; i < 100; i++)
+    map.find(i);
+  map.remove(42);
+  const aisdi::MapStats stats = map.stats();
+
+  BOOST_CHECK_EQUAL(stats.lookups, 201);
+  BOOST_CHECK_EQUAL(stats.probesPerLookup.count(), 201);
+  BOOST_CHECK_GE(stats.probes, 101); // every find and remove hits
+  BOOST_CHECK_GE(stats.comparisons, 101);
+  BOOST_CHECK_GE(stats.rebalances, 3); // grown from 16 to 128 buckets
+  BOOST_CHECK_GE(stats.allocations, 17 + 100 + 33 + 65 + 129);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithoutStats_WhenUsingIt_ThenNothingIsCountedNorStored,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+
+  map.find(42);
+
+  BOOST_CHECK_EQUAL(map.stats().lookups, 0);
+  BOOST_CHECK_EQUAL(sizeof(map), sizeof(std::vector<int>) + sizeof(std::size_t) + sizeof(std::uint64_t));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMallocChunks_WhenEstimating_ThenHeaderAlignmentAndMinimumAreApplied)
+{
+  const std::size_t word = sizeof(std::size_t);
+
+  BOOST_CHECK_EQUAL(aisdi::mallocChunkBytes(1), 4 * word);
+  BOOST_CHECK_EQUAL(aisdi::mallocChunkBytes(3 * word), 4 * word);
+  BOOST_CHECK_EQUAL(aisdi::mallocChunkBytes(3 * word + 1), 6 * word);
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenRemovingValueByKey_ThenExceptionIsThrown,
                               K,
                               TestedKeyTypes)
@@ -609,10 +716,14 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRemovingByBeginIterator_ThenI
                               TestedKeyTypes)
 {
   Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const bool isAliceFirst = map.begin()->first == 42;
 
   map.remove(map.begin());
 
-  thenMapContainsItems(map, { { 42, "Alice" } });
+  if (isAliceFirst)
+    thenMapContainsItems(map, { { 27, "Bob" } });
+  else
+    thenMapContainsItems(map, { { 42, "Alice" } });
 }
 
 // MY TEST
@@ -628,10 +739,11 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSingleItemMap_WhenRemovingValueByKeyAndAdding
   map[34] = "abc";
   map[48] = "xkcd";
   auto it = map.begin();
+  const K firstKey = it->first;
   it++;
 
   thenMapContainsItems(map, { { 34, "abc" }, { 48, "xkcd" } });
-  BOOST_CHECK_EQUAL(it->first, 48);
+  BOOST_CHECK_EQUAL(it->first, firstKey == 34 ? 48 : 34);
 }
 
 // MY TEST
@@ -643,10 +755,13 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenThreeItemMap_WhenDereferencingDecrementedEndI
 
   map[34] = "abc";
   map[48] = "xkcd";
+  auto lastIt = map.begin();
+  lastIt++;
+  lastIt++;
   auto it = map.end();
   it--;
 
-  BOOST_CHECK_EQUAL(it->first, 48);
+  BOOST_CHECK_EQUAL(it->first, lastIt->first);
 }
 
 // MY TEST
@@ -668,6 +783,626 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSingleItemMap_WhenRemovingValueByKey_ThenDecr
 }
 
 
+template <typename K>
+struct ConstantHash
+{
+  std::size_t operator()(const K&) const
+  {
+    return 7;
+  }
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHash_WhenAddingAndRemovingItems_ThenItemsAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, ConstantHash<K>> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  map.remove(27);
+  map[1410] = "Grunwald";
+
+  BOOST_CHECK_EQUAL(map.getSize(), 3);
+  BOOST_CHECK(map.find(27) == map.end());
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
+  BOOST_CHECK_EQUAL(map.valueOf(13), "Chuck");
+  BOOST_CHECK_EQUAL(map.valueOf(1410), "Grunwald");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHash_WhenComputingBucketHistogram_ThenOneChainHoldsAllItems,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, ConstantHash<K>> map;
+  for (int i = 0; i < 5; i++)
+    map[i] = "";
+
+  const aisdi::BucketHistogram histogram = map.bucketHistogram();
+
+  BOOST_CHECK_EQUAL(histogram.buckets, 16);
+  BOOST_CHECK_EQUAL(histogram.emptyBuckets, 15);
+  BOOST_CHECK_EQUAL(histogram.maxChain, 5);
+  BOOST_CHECK_EQUAL(histogram.treeifiedBuckets, 0);
+  const std::vector<std::size_t> expected = { 15, 0, 0, 0, 0, 1 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(histogram.chainLengths.begin(), histogram.chainLengths.end(),
+                                expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenComputingBucketHistogram_ThenEveryBucketAndItemIsCounted,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (int i = 0; i < 1000; i++)
+    map[i * 7] = "";
+
+  const aisdi::BucketHistogram histogram = map.bucketHistogram();
+
+  std::size_t buckets = 0, items = 0;
+  for (std::size_t length = 0; length < histogram.chainLengths.size(); length++) {
+    buckets += histogram.chainLengths[length];
+    items += length * histogram.chainLengths[length];
+  }
+  BOOST_CHECK_EQUAL(buckets, histogram.buckets);
+  BOOST_CHECK_EQUAL(items, 1000);
+  BOOST_CHECK_EQUAL(histogram.chainLengths.size(), histogram.maxChain + 1);
+  BOOST_CHECK_EQUAL(histogram.chainLengths[0], histogram.emptyBuckets);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapCountingStatsWithCollidingHash_WhenFindingLastItem_ThenWholeChainIsProbed,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, ConstantHash<K>, aisdi::EqualTo<K>, false, aisdi::CountingStats> map;
+  for (int i = 0; i < 8; i++)
+    map[i] = "";
+
+  map.find(7);
+  const aisdi::MapStats stats = map.stats();
+
+  BOOST_CHECK_EQUAL(stats.probesPerLookup.max(), 8);
+  BOOST_CHECK_EQUAL(stats.rebalances, 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHash_WhenAddingManyItemsAndRemovingMost_ThenRestIsFoundAndIterated,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, ConstantHash<K>> map;
+  std::map<K, std::string> expected;
+  for (K key = 0; key < 100; ++key)
+    map[(key * 37) % 100] = std::to_string((key * 37) % 100);
+  for (K key = 0; key < 95; ++key)
+    map.remove(key);
+  for (K key = 95; key < 100; ++key)
+    expected[key] = std::to_string(key);
+
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+  BOOST_CHECK(map.find(50) == map.end());
+  for (const auto& item : expected)
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+
+  std::map<K, int> visits;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    visits[it->first]++;
+  for (auto it = map.end(); it != map.begin(); )
+    visits[(--it)->first]++;
+  BOOST_CHECK_EQUAL(visits.size(), expected.size());
+  for (const auto& visit : visits)
+    BOOST_CHECK_EQUAL(visit.second, 2);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHash_WhenIteratingBothWays_ThenEveryItemIsVisitedOnce,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, ConstantHash<K>> map;
+  std::map<K, int> visits;
+  for (K key = 0; key < 30; ++key)
+    map[key] = std::string{};
+
+  for (auto it = map.begin(); it != map.end(); ++it)
+    visits[it->first]++;
+  for (auto it = map.end(); it != map.begin(); )
+    visits[(--it)->first]++;
+
+  BOOST_CHECK_EQUAL(visits.size(), 30);
+  for (const auto& visit : visits)
+    BOOST_CHECK_EQUAL(visit.second, 2);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHash_WhenLookingUpKeysInterleaved_ThenEachKeyIsReportedAsFind,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, ConstantHash<K>> map;
+  std::vector<K> keys;
+  for (K key = 0; key < 40; ++key)
+  {
+    if (key % 4 != 0)
+      map[key] = std::string{};
+    keys.push_back(39 - key);
+  }
+
+  aisdi::interleavedFind(map, keys.data(), keys.size(), 4,
+    [&](std::size_t index, typename aisdi::HashMap<K, std::string, ConstantHash<K>>::const_iterator position)
+    {
+      BOOST_CHECK(position == map.find(keys[index]));
+    });
+}
+
+template <typename K>
+struct LastDigitHash
+{
+  std::size_t operator()(const K& key) const
+  {
+    return std::hash<K>{}(key % 10);
+  }
+};
+
+template <typename K>
+struct LastDigitEqual
+{
+  bool operator()(const K& first, const K& second) const
+  {
+    return first % 10 == second % 10;
+  }
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCustomKeyEqual_WhenAddingEquivalentKey_ThenExistingItemIsChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, LastDigitHash<K>, LastDigitEqual<K>> map;
+
+  map[5] = "five";
+  map[15] = "fifteen";
+
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(25), "fifteen");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCustomKeyEqualAndCollidingHash_WhenChainIsTreeified_ThenEquivalentKeysAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, ConstantHash<K>, LastDigitEqual<K>> map;
+  for (K key = 0; key < 10; ++key)
+    map[key] = std::to_string(key);
+
+  for (K key = 10; key < 20; ++key)
+  {
+    BOOST_CHECK(map.find(key) != map.end());
+    BOOST_CHECK(map.tryGet(key) != nullptr);
+    map[key] += "!";
+  }
+  map.remove(13);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 9);
+  BOOST_CHECK_EQUAL(map.valueOf(27), "7!");
+  BOOST_CHECK(map.find(3) == map.end());
+  BOOST_CHECK(map.bucketHistogram().treeifiedBuckets == 1);
+  const std::vector<K> keys = { 21, 33, 45 };
+  std::vector<std::size_t> found;
+  aisdi::interleavedFind(map, keys.data(), keys.size(), 3,
+    [&](std::size_t index, typename decltype(map)::const_iterator position)
+    {
+      if (position != map.end())
+        found.push_back(index);
+    });
+  BOOST_CHECK((found == std::vector<std::size_t>{ 0, 2 }));
+}
+
+// equality only, no operator< - a treeified chain orders such keys by hash and searches equal hashes linearly
+struct Colour
+{
+  int red, green, blue;
+
+  bool operator==(const Colour& other) const
+  {
+    return red == other.red && green == other.green && blue == other.blue;
+  }
+};
+
+struct ColourHash
+{
+  std::size_t operator()(const Colour& colour) const
+  {
+    return static_cast<std::size_t>(colour.red % 2);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(GivenKeysWithoutOrderAndCollidingHash_WhenChainIsTreeified_ThenItemsAreFoundAndRemoved)
+{
+  aisdi::HashMap<Colour, int, ColourHash, std::equal_to<Colour>> map;
+  for (int i = 0; i < 100; ++i)
+    map[Colour{ 2 * i, i, 0 }] = i;
+
+  for (int i = 0; i < 100; i += 2)
+    map.remove(Colour{ 2 * i, i, 0 });
+
+  BOOST_CHECK_EQUAL(map.getSize(), 50);
+  for (int i = 1; i < 100; i += 2)
+    BOOST_CHECK_EQUAL(map.valueOf(Colour{ 2 * i, i, 0 }), i);
+  BOOST_CHECK(map.find(Colour{ 0, 0, 0 }) == map.end());
+  const auto copy = map;
+  BOOST_CHECK(copy == map);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithStridedKeys_WhenIteratingBothWays_ThenEveryItemIsVisitedOnce,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, int> visits;
+  for (K key = 0; key < 200; ++key)
+    map[key * 16384] = std::string{};
+
+  for (auto it = map.begin(); it != map.end(); ++it)
+    visits[it->first]++;
+  for (auto it = map.end(); it != map.begin(); )
+    visits[(--it)->first]++;
+
+  BOOST_CHECK_EQUAL(visits.size(), 200);
+  for (const auto& visit : visits)
+    BOOST_CHECK_EQUAL(visit.second, 2);
+}
+
+template <typename K>
+using CachingMap = aisdi::HashMap<K, std::string, aisdi::Hash<K>, std::equal_to<K>, true>;
+
+template <typename M>
+void whenAddingManyItemsAndRemovingHalf_ThenRestIsFoundAndIterated(M& map)
+{
+  using K = typename M::key_type;
+  for (K key = 0; key < 5000; ++key)
+    map[key] = std::to_string(key);
+  for (K key = 0; key < 5000; key += 2)
+    map.remove(key);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2500);
+  for (K key = 0; key < 5000; ++key)
+  {
+    if (key % 2 == 0)
+      BOOST_CHECK(map.find(key) == map.end());
+    else
+      BOOST_CHECK_EQUAL(map.valueOf(key), std::to_string(key));
+  }
+
+  std::size_t visited = 0;
+  for (auto it = map.begin(); it != map.end(); ++it)
+  {
+    BOOST_CHECK_EQUAL(it->first % 2, 1);
+    visited++;
+  }
+  BOOST_CHECK_EQUAL(visited, 2500);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenGrowingMap_WhenRemovingHalfOfItems_ThenRestIsFoundAndIterated,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  whenAddingManyItemsAndRemovingHalf_ThenRestIsFoundAndIterated(map);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenGrowingMapCachingHashes_WhenRemovingHalfOfItems_ThenRestIsFoundAndIterated,
+                              K,
+                              TestedKeyTypes)
+{
+  CachingMap<K> map;
+
+  whenAddingManyItemsAndRemovingHalf_ThenRestIsFoundAndIterated(map);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMapCachingHashes_WhenCreatingCopy_ThenAllItemsAreCopied,
+                              K,
+                              TestedKeyTypes)
+{
+  CachingMap<K> map = { { 753, "Rome" }, { 1789, "Paris" } };
+
+  const CachingMap<K> other{map};
+  map.remove(753);
+
+  BOOST_CHECK_EQUAL(other.getSize(), 2);
+  BOOST_CHECK_EQUAL(other.valueOf(753), "Rome");
+  BOOST_CHECK_EQUAL(other.valueOf(1789), "Paris");
+}
+
+template <typename K>
+using InlineMap = aisdi::HashMap<K, std::string, aisdi::Hash<K>, aisdi::EqualTo<K>, false, aisdi::NoStats, 4>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenInlineMapWithFewItems_WhenLookingThemUp_ThenTheyAreFoundWithoutAllocating,
+                              K,
+                              TestedKeyTypes)
+{
+  InlineMap<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  map[27] = "Dan";
+
+  BOOST_CHECK(map.isInline());
+  BOOST_CHECK_EQUAL(map.memoryUsage().allocations, 0);
+  BOOST_CHECK_EQUAL(map.getSize(), 3);
+  BOOST_CHECK_EQUAL(map.valueOf(27), "Dan");
+  BOOST_CHECK_EQUAL(map.find(13)->second, "Chuck");
+  BOOST_CHECK(map.find(5) == map.end());
+  BOOST_CHECK(map.tryGet(5) == nullptr);
+  BOOST_CHECK_THROW(map.valueOf(5), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFullInlineMap_WhenAddingItems_ThenTheyAreMovedToTable,
+                              K,
+                              TestedKeyTypes)
+{
+  InlineMap<K> map;
+  for (K key = 0; key < 4; ++key)
+    map[key] = std::to_string(key);
+  BOOST_CHECK(map.isInline());
+
+  for (K key = 4; key < 100; ++key)
+    map[key] = std::to_string(key);
+
+  BOOST_CHECK(!map.isInline());
+  BOOST_CHECK_GT(map.memoryUsage().allocations, 0);
+  BOOST_CHECK_EQUAL(map.getSize(), 100);
+  for (K key = 0; key < 100; ++key)
+    BOOST_CHECK_EQUAL(map.valueOf(key), std::to_string(key));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenInlineMap_WhenRemovingItemsAndIteratingBothWays_ThenRestIsVisitedOnce,
+                              K,
+                              TestedKeyTypes)
+{
+  InlineMap<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" }, { 1410, "Grunwald" } };
+
+  map.remove(42);
+  map.remove(map.find(1410));
+  BOOST_CHECK_THROW(map.remove(42), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+
+  std::map<K, int> visits;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    visits[it->first]++;
+  for (auto it = map.end(); it != map.begin(); )
+    visits[(--it)->first]++;
+  BOOST_CHECK_EQUAL(visits.size(), 2);
+  BOOST_CHECK_EQUAL(visits[27], 2);
+  BOOST_CHECK_EQUAL(visits[13], 2);
+  BOOST_CHECK_THROW(--map.begin(), std::out_of_range);
+  BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+}
+
+struct FragileValue
+{
+  static bool failing;
+
+  FragileValue()
+  {
+    if (failing)
+      throw std::runtime_error("cannot construct");
+  }
+};
+
+bool FragileValue::failing = false;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenInlineMap_WhenAddingItemThrows_ThenSizeIsUnchanged,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, FragileValue, aisdi::Hash<K>, aisdi::EqualTo<K>, false, aisdi::NoStats, 4> map;
+  map[42];
+  map[27];
+
+  FragileValue::failing = true;
+  BOOST_CHECK_THROW(map[13], std::runtime_error);
+  FragileValue::failing = false;
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+  BOOST_CHECK(map.find(13) == map.end());
+  std::size_t iterated = 0;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    iterated++;
+  BOOST_CHECK_EQUAL(iterated, 2);
+  map[13];
+  BOOST_CHECK_EQUAL(map.getSize(), 3);
+  BOOST_CHECK(map.isInline());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenInlineMapAndMapWithTable_WhenCopyingMovingAndSwapping_ThenItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  InlineMap<K> small = { { 42, "Alice" }, { 27, "Bob" } };
+  InlineMap<K> big;
+  for (K key = 0; key < 10; ++key)
+    big[key] = std::to_string(key);
+
+  InlineMap<K> copy(small);
+  InlineMap<K> moved(std::move(big));
+  std::swap(small, moved);
+
+  BOOST_CHECK(copy.isInline());
+  BOOST_CHECK_EQUAL(copy.valueOf(42), "Alice");
+  BOOST_CHECK(big.isEmpty());
+  BOOST_CHECK(!small.isInline());
+  BOOST_CHECK_EQUAL(small.getSize(), 10);
+  BOOST_CHECK_EQUAL(small.valueOf(9), "9");
+  BOOST_CHECK(moved.isInline());
+  BOOST_CHECK(moved == copy);
+  copy = small;
+  BOOST_CHECK(copy == small);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenInlineMapCountingStats_WhenFindingLastItem_ThenEveryInlineItemIsCompared,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::HashMap<K, std::string, aisdi::Hash<K>, aisdi::EqualTo<K>, false, aisdi::CountingStats, 4> map;
+  for (K key = 0; key < 4; ++key)
+    map[key] = "";
+
+  map.find(3);
+  const aisdi::MapStats stats = map.stats();
+
+  BOOST_CHECK_EQUAL(stats.comparisonsPerLookup.max(), 4);
+  BOOST_CHECK_EQUAL(stats.allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringHash_WhenHashingEqualTextsOfDifferentTypes_ThenHashesAreEqual)
+{
+  const std::string text = "a key long enough not to fit into one word";
+  const aisdi::Hash<std::string> hash;
+
+  BOOST_CHECK_EQUAL(hash(text), hash(std::string_view(text)));
+  BOOST_CHECK_EQUAL(hash(text), hash(text.c_str()));
+  BOOST_CHECK(hash(text) != hash(text.substr(1)));
+  BOOST_CHECK(hash(std::string("a")) != hash(std::string("a", 2)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenKeysCollidingWithoutSeed_WhenHashingWithSeed_ThenHashesDiffer)
+{
+  // a first word equal to the multiplier constant zeroes the product of the first fold
+  const std::uint64_t zeroingWord = 0x589965cc75374cc3ull;
+  std::string first(sizeof(zeroingWord), '\0');
+  std::memcpy(&first[0], &zeroingWord, sizeof(zeroingWord));
+  std::string second = first;
+  first += "abcdefgh.";
+  second += "ijklmnop!";
+  const aisdi::Hash<std::string> hash;
+
+  BOOST_CHECK_EQUAL(hash(first), hash(second));
+  BOOST_CHECK(hash(first, 1) != hash(second, 1));
+  BOOST_CHECK(aisdi::seededHash< aisdi::Hash<std::string> >(first, 1)
+              != aisdi::seededHash< aisdi::Hash<std::string> >(second, 1));
+  BOOST_CHECK_EQUAL(hash(first, 0), hash(first));
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMapWithStringKeys_WhenGettingIterators_ThenBeginEqualsEnd)
+{
+  aisdi::HashMap<std::string, int> map;
+
+  BOOST_CHECK(map.begin() == map.end());
+  BOOST_CHECK(map.find("missing") == map.end());
+  BOOST_CHECK_THROW(--(map.begin()), std::out_of_range);
+  BOOST_CHECK_THROW(map.valueOf("missing"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapWithStringKeys_WhenSearchingByStringViewOrCString_ThenItemIsReturned)
+{
+  aisdi::HashMap<std::string, int> map = { { "short", 1 }, { "a key much longer than the inline buffer", 2 } };
+  const std::string_view view = "a key much longer than the inline buffer, not all of it";
+
+  const auto byView = map.find(view.substr(0, 40));
+  const auto byCString = map.find("short");
+
+  BOOST_REQUIRE(byView != map.end());
+  BOOST_CHECK_EQUAL(byView->second, 2);
+  BOOST_REQUIRE(byCString != map.end());
+  BOOST_CHECK_EQUAL(byCString->second, 1);
+  BOOST_CHECK(map.find(view) == map.end());
+  BOOST_CHECK(map.find("shor") == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapWithManyStringKeys_WhenIteratingBothWays_ThenEveryItemIsVisitedOnce)
+{
+  aisdi::HashMap<std::string, int> map;
+  std::map<std::string, int> visits;
+  for (int i = 0; i < 300; ++i)
+    map["key number " + std::to_string(i)] = i;
+
+  for (auto it = map.begin(); it != map.end(); ++it)
+    visits[it->first]++;
+  for (auto it = map.end(); it != map.begin(); )
+    visits[(--it)->first]++;
+
+  BOOST_CHECK_EQUAL(visits.size(), 300);
+  for (const auto& visit : visits)
+    BOOST_CHECK_EQUAL(visit.second, 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapWithStringKeys_WhenAddingAndRemovingItems_ThenItemsAreFound)
+{
+  aisdi::HashMap<std::string, int> map = { { "Alice", 42 }, { "Bob", 27 } };
+
+  map["Chuck"] = 13;
+  map.remove("Bob");
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+  BOOST_CHECK_EQUAL(map.valueOf("Alice"), 42);
+  BOOST_CHECK_EQUAL(map.valueOf("Chuck"), 13);
+  BOOST_CHECK(map.find("Bob") == map.end());
+  BOOST_CHECK(map.find("") == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenLookingUpKeysInterleaved_ThenEachKeyIsReportedAsFind,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" }, { 1410, "Grunwald" } };
+  const std::vector<K> keys = { 13, 7, 1410, 42, 99, 27, 27, 5 };
+  std::vector<int> reportCount(keys.size(), 0);
+
+  aisdi::interleavedFind(map, keys.data(), keys.size(), 3,
+    [&](std::size_t index, typename Map<K>::const_iterator position)
+    {
+      reportCount[index]++;
+      BOOST_CHECK(position == map.find(keys[index]));
+    });
+
+  for (const auto count : reportCount)
+    BOOST_CHECK_EQUAL(count, 1);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenLookingUpKeysInterleaved_ThenEndIsReported,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+  const std::vector<K> keys = { 1, 2 };
+  std::size_t reportCount = 0;
+
+  aisdi::interleavedFind(map, keys.data(), keys.size(), 8,
+    [&](std::size_t, typename Map<K>::const_iterator position)
+    {
+      reportCount++;
+      BOOST_CHECK(position == map.cend());
+    });
+
+  BOOST_CHECK_EQUAL(reportCount, keys.size());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenVisitingChunks_ThenTheyHoldAllItemsInIterationOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K key = 0; key < 1000; ++key)
+    map[key * 7] = std::to_string(key);
+  map.remove(14);
+
+  std::vector<const typename Map<K>::value_type*> visited;
+  std::size_t chunks = 0;
+  map.forEachChunk([&](const auto chunk) {
+    BOOST_CHECK(!chunk.empty());
+    BOOST_CHECK(chunk.size() <= Map<K>::CHUNK_SIZE);
+    visited.insert(visited.end(), chunk.begin(), chunk.end());
+    ++chunks;
+  });
+
+  std::vector<const typename Map<K>::value_type*> iterated;
+  for (const auto& item : map)
+    iterated.push_back(&item);
+  BOOST_CHECK(visited == iterated);
+  BOOST_CHECK_EQUAL(chunks, (map.getSize() + Map<K>::CHUNK_SIZE - 1) / Map<K>::CHUNK_SIZE);
+  Map<K>().forEachChunk([](auto) { BOOST_ERROR("empty map has no chunks"); });
+
+  InlineMap<K> small = { { 42, "Alice" }, { 27, "Bob" } };
+  small.forEachChunk([&](const auto chunk) {
+    BOOST_REQUIRE_EQUAL(chunk.size(), 2);
+    BOOST_CHECK(chunk[0] == &*small.begin());
+  });
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
@@ -0,0 +1,92 @@
+#include <LatencyHistogram.h>
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(LatencyHistogramTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyHistogram_WhenAskingForPercentile_ThenZeroIsReturned)
+{
+  aisdi::LatencyHistogram histogram;
+
+  BOOST_CHECK_EQUAL(histogram.count(), 0u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.99), 0u);
+  BOOST_CHECK_EQUAL(histogram.max(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSmallValues_WhenRecording_ThenPercentilesAreExact)
+{
+  aisdi::LatencyHistogram histogram;
+
+  for (std::uint64_t value = 1; value <= 100; value++)
+    histogram.record(value);
+
+  BOOST_CHECK_EQUAL(histogram.count(), 100u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.5), 50u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.9), 90u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.99), 99u);
+  BOOST_CHECK_EQUAL(histogram.percentile(1), 100u);
+  BOOST_CHECK_EQUAL(histogram.max(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLargeValues_WhenAskingForPercentile_ThenRelativeErrorIsSmall)
+{
+  aisdi::LatencyHistogram histogram;
+
+  histogram.record(1000, 99);
+  histogram.record(1000000);
+
+  BOOST_CHECK_GE(histogram.percentile(0.5), 1000u);
+  BOOST_CHECK_LE(histogram.percentile(0.5), 1000u + 1000u / 64);
+  BOOST_CHECK_EQUAL(histogram.percentile(1), 1000000u);
+  BOOST_CHECK_EQUAL(histogram.max(), 1000000u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenHugeValue_WhenRecording_ThenItIsCounted)
+{
+  aisdi::LatencyHistogram histogram;
+
+  histogram.record(UINT64_MAX);
+
+  BOOST_CHECK_EQUAL(histogram.count(), 1u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.5), UINT64_MAX);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoHistograms_WhenMerging_ThenCountsAndMaxAreCombined)
+{
+  aisdi::LatencyHistogram first, second;
+  first.record(10, 3);
+  second.record(20);
+  second.record(5000);
+
+  first.merge(second);
+
+  BOOST_CHECK_EQUAL(first.count(), 5u);
+  BOOST_CHECK_EQUAL(first.percentile(0.5), 10u);
+  BOOST_CHECK_EQUAL(first.max(), 5000u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenHistogram_WhenDumping_ThenNonEmptyBucketsArePrinted)
+{
+  aisdi::LatencyHistogram histogram;
+  histogram.record(3, 2);
+  histogram.record(1000);
+  std::ostringstream out;
+
+  histogram.dump(out);
+
+  BOOST_CHECK_EQUAL(out.str(), "3\t3\t2\n1000\t1007\t1\n");
+}
+
+BOOST_AUTO_TEST_CASE(GivenFractionOutOfRange_WhenAskingForPercentile_ThenExceptionIsThrown)
+{
+  aisdi::LatencyHistogram histogram;
+
+  BOOST_CHECK_THROW(histogram.percentile(1.5), std::invalid_argument);
+  BOOST_CHECK_THROW(histogram.percentile(-0.1), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
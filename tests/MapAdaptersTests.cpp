@@ -0,0 +1,77 @@
+#include <MapAdapters.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedMapTypes = boost::mpl::list<aisdi::StdMap<std::int32_t, std::string>,
+                                        aisdi::StdUnorderedMap<std::int32_t, std::string>,
+                                        aisdi::SortedVectorMap<std::int32_t, std::string>>;
+
+BOOST_AUTO_TEST_SUITE(MapAdaptersTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItems_ThenTheyCanBeFound,
+                              M,
+                              TestedMapTypes)
+{
+  M map;
+
+  map[42] = "Alice";
+  map[7] = "Bob";
+  map[42] = "Chuck";
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Chuck");
+  BOOST_CHECK_EQUAL(map.find(7)->second, "Bob");
+  BOOST_REQUIRE(map.tryGet(7) != nullptr);
+  BOOST_CHECK_EQUAL(*map.tryGet(7), "Bob");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenLookingUpMissingKey_ThenMissIsReported,
+                              M,
+                              TestedMapTypes)
+{
+  M map;
+  map[42] = "Alice";
+
+  BOOST_CHECK(map.tryGet(1) == nullptr);
+  BOOST_CHECK(map.find(1) == map.end());
+  BOOST_CHECK_THROW(map.valueOf(1), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(1), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingItems_ThenOnlyOthersRemain,
+                              M,
+                              TestedMapTypes)
+{
+  M map;
+  for (int i = 0; i < 10; i++)
+    map[i] = std::to_string(i);
+
+  map.remove(3);
+  map.remove(map.find(7));
+
+  BOOST_CHECK_EQUAL(map.getSize(), 8);
+  BOOST_CHECK(map.tryGet(3) == nullptr);
+  BOOST_CHECK(map.tryGet(7) == nullptr);
+  BOOST_CHECK_EQUAL(map.valueOf(8), "8");
+}
+
+BOOST_AUTO_TEST_CASE(GivenSortedVectorMap_WhenIterating_ThenKeysAreSorted)
+{
+  aisdi::SortedVectorMap<std::int32_t, std::string> map;
+  for (int key : { 5, -3, 17, 0, 9 })
+    map[key] = "";
+
+  std::vector<std::int32_t> keys;
+  for (const auto& item : map)
+    keys.push_back(item.first);
+
+  BOOST_CHECK(keys == std::vector<std::int32_t>({ -3, 0, 5, 9, 17 }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
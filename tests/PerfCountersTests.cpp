@@ -0,0 +1,33 @@
+#include <PerfCounters.h>
+
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(PerfCountersTests)
+
+BOOST_AUTO_TEST_CASE(GivenCounters_WhenMeasuring_ThenEveryCounterIsCountedOrNaN)
+{
+  aisdi::PerfCounters counters;
+  volatile long sum = 0;
+
+  counters.start();
+  for (int i = 0; i < 100000; i++)
+    sum += i;
+  const auto values = counters.stop();
+
+  BOOST_REQUIRE_EQUAL(values.size(), counters.names().size());
+  for (const auto value : values)
+    BOOST_CHECK(std::isnan(value) || value >= 0);
+  if (!counters.isAvailable())
+    BOOST_CHECK(!counters.unavailableReason().empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenCountersNotStarted_WhenStopping_ThenNothingFails)
+{
+  aisdi::PerfCounters counters;
+
+  BOOST_CHECK_EQUAL(counters.stop().size(), counters.names().size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,264 @@
+#include <SplitHashMap.h>
+
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::SplitHashMap<K, std::string>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(SplitHashMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  for (const auto& item : expected)
+  {
+    const auto it = map.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_MESSAGE(it->second == item.second,
+                        "Wrong value in map for key: " << item.first
+                        << " (expected: \"" << item.second
+                        << "\" got: \"" << it->second << "\")");
+  }
+
+  std::size_t iterated = 0;
+  for (auto it = map.begin(); it != map.end(); ++it, ++iterated)
+    BOOST_CHECK(expected.count(it->first) == 1);
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+  BOOST_CHECK(map.keys().empty());
+  BOOST_CHECK(map.values().empty());
+  BOOST_CHECK(map.tryGet(42) == nullptr);
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItems_ThenTheyAreFoundInInsertionOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map[1410] = "Grunwald";
+  map[27] = "Chuck";
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Chuck" }, { 1410, "Grunwald" } });
+  const std::vector<K> expectedKeys = { 42, 27, 1410 };
+  const std::vector<std::string> expectedValues = { "Alice", "Chuck", "Grunwald" };
+  BOOST_CHECK_EQUAL_COLLECTIONS(map.keys().begin(), map.keys().end(), expectedKeys.begin(), expectedKeys.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(map.values().begin(), map.values().end(),
+                                expectedValues.begin(), expectedValues.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenRemovingOne_ThenLastItemTakesItsPlace,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" }, { 7, "Dan" } };
+
+  map.remove(27);
+  map.remove(map.find(7));
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 13, "Chuck" } });
+  const std::vector<K> expectedKeys = { 42, 13 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(map.keys().begin(), map.keys().end(), expectedKeys.begin(), expectedKeys.end());
+  BOOST_CHECK_EQUAL(map.values()[1], "Chuck");
+  BOOST_CHECK_THROW(map.remove(27), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingAndRemovingRandomly_ThenItMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  std::mt19937 generator(1410);
+  std::uniform_int_distribution<int> keys(0, 3000);
+  std::map<K, std::string> expected;
+  Map<K> map;
+
+  for (int i = 0; i < 50000; ++i)
+  {
+    const K key = keys(generator);
+    if (expected.count(key) == 1 && i % 2 == 0)
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+  for (std::size_t position = 0; position < map.getSize(); ++position)
+    BOOST_CHECK_EQUAL(map.values()[position], expected[map.keys()[position]]);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithNumbers_WhenSummingValuesView_ThenSumMatchesIteration,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::SplitHashMap<K, long int> map;
+  for (K key = 0; key < 10000; ++key)
+    map[key * 7] = static_cast<long int>(key);
+  map.remove(0);
+  map.remove(70);
+
+  long int iterated = 0;
+  for (const auto& item : map)
+    iterated += item.second;
+  const auto values = map.values();
+
+  BOOST_CHECK_EQUAL(std::accumulate(values.begin(), values.end(), 0l), iterated);
+  BOOST_CHECK_EQUAL(iterated, 10000l * 9999 / 2 - 10);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenChangingValuesThroughViewAndIterator_ThenLookupsSeeThem,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  for (auto& value : map.values())
+    value += "!";
+  map.begin()->second = "Chuck";
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Chuck");
+  BOOST_CHECK_EQUAL(map.valueOf(27), "Bob!");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenVisitingChunks_ThenKeysAndValuesArePassedOnceInIterationOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  std::size_t chunks = 0;
+  map.forEachChunk([&](const auto keys, const auto values) {
+    BOOST_REQUIRE_EQUAL(keys.size(), map.getSize());
+    BOOST_REQUIRE_EQUAL(values.size(), map.getSize());
+    std::size_t position = 0;
+    for (auto it = map.begin(); it != map.end(); ++it, ++position)
+    {
+      BOOST_CHECK_EQUAL(keys[position], it->first);
+      BOOST_CHECK_EQUAL(values[position], it->second);
+    }
+    ++chunks;
+  });
+
+  BOOST_CHECK_EQUAL(chunks, 1);
+  Map<K>().forEachChunk([](auto, auto) { BOOST_ERROR("empty map has no chunks"); });
+}
+
+// a value whose default constructor throws while failing is set
+struct FragileValue
+{
+  static bool failing;
+
+  FragileValue()
+  {
+    if (failing)
+      throw std::runtime_error("cannot construct");
+  }
+};
+
+bool FragileValue::failing = false;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingItemThrows_ThenIndexAndArraysAreUnchanged,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::SplitHashMap<K, FragileValue> map;
+  for (K key = 0; key < 100; ++key)
+    map[key];
+
+  FragileValue::failing = true;
+  BOOST_CHECK_THROW(map[1410], std::runtime_error);
+  FragileValue::failing = false;
+
+  BOOST_CHECK_EQUAL(map.getSize(), 100);
+  BOOST_CHECK_EQUAL(map.keys().size(), 100);
+  BOOST_CHECK_EQUAL(map.values().size(), 100);
+  BOOST_CHECK(map.find(1410) == map.end());
+  map[1410];
+  BOOST_CHECK_EQUAL(map.keys()[100], 1410);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenMovingIterators_ThenEndsThrow,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  auto it = map.end();
+  --it;
+  --it;
+
+  BOOST_CHECK(it == map.begin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+  BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenCopyingMovingAndAssigning_ThenMapsAreEqual,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map<K> reordered = { { 27, "Bob" }, { 42, "Alice" } };
+
+  const Map<K> copy(map);
+  Map<K> assigned;
+  assigned = map;
+  const Map<K> moved(std::move(map));
+
+  BOOST_CHECK(copy == moved);
+  BOOST_CHECK(assigned == moved);
+  BOOST_CHECK(reordered == moved);
+  assigned[42] = "Chuck";
+  BOOST_CHECK(assigned != copy);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenComputingMemoryUsage_ThenItIsIndexAndTwoArrays,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K key = 0; key < 1000; ++key)
+    map[key] = "";
+
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(usage.allocations, 4);
+  BOOST_CHECK_EQUAL(usage.payloadBytes, 1000 * sizeof(typename Map<K>::value_type));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
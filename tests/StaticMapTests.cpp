@@ -0,0 +1,79 @@
+#include <StaticMap.h>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+enum class Opcode { Add, Sub, Load, Store };
+
+constexpr auto opcodes = aisdi::makeStaticMap<std::string_view, Opcode>({
+  { "store", Opcode::Store }, { "add", Opcode::Add }, { "load", Opcode::Load }, { "sub", Opcode::Sub } });
+
+constexpr auto ports = aisdi::makeStaticMap<std::uint16_t, std::string_view>({
+  { 443, "https" }, { 22, "ssh" }, { 80, "http" }, { 53, "dns" }, { 25, "smtp" } });
+
+// evaluated by the compiler - a failed lookup here would not compile
+static_assert(opcodes.getSize() == 4, "all opcodes are in the map");
+static_assert(opcodes.valueOf("load") == Opcode::Load, "lookup works at compile time");
+static_assert(opcodes.find("jump") == opcodes.end(), "missing key is not found at compile time");
+static_assert(ports.begin()->first == 22, "entries are sorted at compile time");
+
+}
+
+BOOST_AUTO_TEST_SUITE(StaticMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenStaticMap_WhenLookingUpEveryKey_ThenValuesAreFound)
+{
+  BOOST_CHECK(opcodes.valueOf("add") == Opcode::Add);
+  BOOST_CHECK(opcodes.valueOf("sub") == Opcode::Sub);
+  BOOST_CHECK(opcodes.valueOf("load") == Opcode::Load);
+  BOOST_CHECK(*opcodes.tryGet("store") == Opcode::Store);
+  BOOST_CHECK_EQUAL(ports.valueOf(80), "http");
+  BOOST_CHECK_EQUAL(ports.find(443)->second, "https");
+}
+
+BOOST_AUTO_TEST_CASE(GivenStaticMap_WhenLookingUpMissingKeys_ThenMissIsReported)
+{
+  for (std::uint16_t port : { 0, 21, 23, 81, 444, 65535 })
+  {
+    BOOST_CHECK(ports.find(port) == ports.end());
+    BOOST_CHECK(ports.tryGet(port) == nullptr);
+  }
+  BOOST_CHECK(opcodes.find("") == opcodes.end());
+  BOOST_CHECK(opcodes.find("zzz") == opcodes.end());
+  BOOST_CHECK_THROW(opcodes.valueOf("jump"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStaticMap_WhenIterating_ThenKeysAreInAscendingOrder)
+{
+  const std::vector<std::uint16_t> expected = { 22, 25, 53, 80, 443 };
+
+  std::vector<std::uint16_t> keys;
+  for (const auto& entry : ports)
+    keys.push_back(entry.first);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(keys.begin(), keys.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenItemsWithRepeatedKey_WhenBuildingMapAtRunTime_ThenExceptionIsThrown)
+{
+  const std::pair<int, int> items[] = { { 1, 10 }, { 2, 20 }, { 1, 30 } };
+
+  BOOST_CHECK_THROW(aisdi::makeStaticMap(items), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSingleItemMap_WhenLookingUpKeys_ThenOnlyThatKeyIsFound)
+{
+  constexpr auto map = aisdi::makeStaticMap<int, int>({ { 42, 1 } });
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), 1);
+  BOOST_CHECK(map.find(41) == map.end());
+  BOOST_CHECK(map.find(43) == map.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
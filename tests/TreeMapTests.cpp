@@ -1,8 +1,10 @@
 #include <TreeMap.h>
+#include <InterleavedLookup.h>
 
 #include <cstdint>
 #include <string>
 #include <map>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -337,6 +339,25 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenCreatingCopy_ThenAllItemsAreC
   thenMapContainsItems(other, { { 753, "Rome" }, { 1789, "Paris" } });
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenCopiedMap_WhenRemovingAllItemsFromCopy_ThenOriginalIsUnchanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for(int i = 0; i < 100; i++)
+    map[(i * 37) % 100] = std::to_string(i);
+  Map<K> other{map};
+
+  BOOST_CHECK(other == map);
+  BOOST_CHECK_EQUAL((--other.end())->first, 99);
+  for(int i = 0; i < 100; i++)
+    other.remove(i);
+
+  BOOST_CHECK(other.isEmpty());
+  BOOST_CHECK_EQUAL(map.getSize(), 100);
+  BOOST_CHECK_EQUAL(map.valueOf(37), "1");
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenMovingToOther_ThenBothMapsAreEmpty,
                               K,
                               TestedKeyTypes)
@@ -470,6 +491,166 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValueOfAKey_ThenValue
   thenMapContainsItems(map, { { 42, "Chuck" }, { 27, "Bob" } });
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenTryingToGetAnyKey_ThenNullIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.tryGet(1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenTryingToGetMissingKey_ThenNullIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.tryGet(1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenTryingToGetAKey_ThenValueIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  const std::string* value = map.tryGet(27);
+
+  BOOST_REQUIRE(value != nullptr);
+  BOOST_CHECK_EQUAL(*value, "Bob");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValueThroughTryGet_ThenValueIsChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  *map.tryGet(42) = "Chuck";
+
+  thenMapContainsItems(map, { { 42, "Chuck" }, { 27, "Bob" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingItems_ThenMemoryUsageCountsOneNodeEach,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const auto empty = map.memoryUsage();
+
+  map[1] = "one";
+  map[2] = "two";
+  map[3] = "three";
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(empty.allocations, 1); // the sentinel head
+  BOOST_CHECK_EQUAL(empty.payloadBytes, 0);
+  BOOST_CHECK_EQUAL(usage.allocations, 4);
+  BOOST_CHECK_EQUAL(usage.payloadBytes, 3 * sizeof(typename Map<K>::value_type));
+  BOOST_CHECK_GE(usage.heapBytes, usage.requestedBytes);
+  BOOST_CHECK_GE(usage.requestedBytes, usage.payloadBytes + 3 * 3 * sizeof(void*)); // three links per node
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapCountingStats_WhenAddingSortedKeys_ThenDescentDepthIsCounted,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, std::string, aisdi::CountingStats> map;
+
+  for (int i = 1; i <= 10; i++)
+    map[i] = "";
+  map.find(10);
+  map.tryGet(11);
+  const aisdi::MapStats stats = map.stats();
+
+  BOOST_CHECK_EQUAL(stats.lookups, 12);
+  BOOST_CHECK_EQUAL(stats.probes, 45 + 10 + 10); // sorted keys degenerate the tree into a list
+  BOOST_CHECK_EQUAL(stats.comparisons, 90 + 19 + 20);
+  BOOST_CHECK_EQUAL(stats.probesPerLookup.count(), 12);
+  BOOST_CHECK_EQUAL(stats.probesPerLookup.max(), 10);
+  BOOST_CHECK_EQUAL(stats.allocations, map.memoryUsage().allocations);
+  BOOST_CHECK_EQUAL(stats.rebalances, 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapOfSortedKeys_WhenReportingShape_ThenTreeIsAList,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (int i = 1; i <= 5; i++)
+    map[i] = "";
+
+  const aisdi::TreeShape shape = map.shapeReport();
+
+  BOOST_CHECK_EQUAL(shape.size, 5);
+  BOOST_CHECK_EQUAL(shape.height, 5);
+  BOOST_CHECK_EQUAL(shape.minimalHeight, 3);
+  BOOST_CHECK_CLOSE(shape.averageDepth, 3.0, 1e-9);
+  const std::map<int, std::size_t> expected = { { -4, 1 }, { -3, 1 }, { -2, 1 }, { -1, 1 }, { 0, 1 } };
+  BOOST_CHECK(shape.balanceFactors == expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapsOfVariousShapes_WhenCopying_ThenShapeAndItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> list;
+  for (int i = 1; i <= 1000; i++)
+    list[i] = std::to_string(i);
+  const Map<K> zigzag = { { 10, "a" }, { 2, "b" }, { 8, "c" }, { 4, "d" }, { 6, "e" }, { 5, "f" }, { 1, "g" } };
+
+  for (const Map<K>* original : { static_cast<const Map<K>*>(&list), &zigzag }) {
+    const Map<K> copy(*original);
+
+    BOOST_CHECK(copy == *original);
+    const aisdi::TreeShape shape = copy.shapeReport(), originalShape = original->shapeReport();
+    BOOST_CHECK_EQUAL(shape.height, originalShape.height);
+    BOOST_CHECK_CLOSE(shape.averageDepth, originalShape.averageDepth, 1e-9);
+    BOOST_CHECK(shape.balanceFactors == originalShape.balanceFactors);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBalancedMap_WhenReportingShape_ThenEveryNodeIsBalanced,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 4, "" }, { 2, "" }, { 6, "" }, { 1, "" }, { 3, "" }, { 5, "" }, { 7, "" } };
+
+  const aisdi::TreeShape shape = map.shapeReport();
+
+  BOOST_CHECK_EQUAL(shape.height, 3);
+  BOOST_CHECK_EQUAL(shape.minimalHeight, 3);
+  BOOST_CHECK_CLOSE(shape.averageDepth, 17.0 / 7, 1e-9);
+  BOOST_CHECK_EQUAL(shape.balanceFactors.size(), 1);
+  BOOST_CHECK_EQUAL(shape.balanceFactors.at(0), 7);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenReportingShape_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  const aisdi::TreeShape shape = map.shapeReport();
+
+  BOOST_CHECK_EQUAL(shape.height, 0);
+  BOOST_CHECK_EQUAL(shape.averageDepth, 0);
+  BOOST_CHECK(shape.balanceFactors.empty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithoutStats_WhenUsingIt_ThenNothingIsCountedNorStored,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+
+  map.find(42);
+
+  BOOST_CHECK_EQUAL(map.stats().lookups, 0);
+  BOOST_CHECK_EQUAL(sizeof(map), sizeof(void*) + sizeof(std::size_t));
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenRemovingValueByKey_ThenExceptionIsThrown,
                               K,
                               TestedKeyTypes)
@@ -672,6 +853,69 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenGettingNextElement_ThenItemsA
   BOOST_CHECK(it == map.end());
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenLookingUpKeysInterleaved_ThenEachKeyIsReportedAsFind,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" }, { 1410, "Grunwald" } };
+  const std::vector<K> keys = { 13, 7, 1410, 42, 99, 27, 27, 5 };
+  std::vector<int> reportCount(keys.size(), 0);
+
+  aisdi::interleavedFind(map, keys.data(), keys.size(), 3,
+    [&](std::size_t index, typename Map<K>::const_iterator position)
+    {
+      reportCount[index]++;
+      BOOST_CHECK(position == map.find(keys[index]));
+    });
+
+  for (const auto count : reportCount)
+    BOOST_CHECK_EQUAL(count, 1);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenLookingUpKeysInterleaved_ThenEndIsReported,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+  const std::vector<K> keys = { 1, 2 };
+  std::size_t reportCount = 0;
+
+  aisdi::interleavedFind(map, keys.data(), keys.size(), 8,
+    [&](std::size_t, typename Map<K>::const_iterator position)
+    {
+      reportCount++;
+      BOOST_CHECK(position == map.cend());
+    });
+
+  BOOST_CHECK_EQUAL(reportCount, keys.size());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenVisitingChunks_ThenTheyHoldAllItemsInIterationOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K key = 0; key < 1000; ++key)
+    map[key * 7] = std::to_string(key);
+  map.remove(14);
+
+  std::vector<const typename Map<K>::value_type*> visited;
+  std::size_t chunks = 0;
+  map.forEachChunk([&](const auto chunk) {
+    BOOST_CHECK(!chunk.empty());
+    BOOST_CHECK(chunk.size() <= Map<K>::CHUNK_SIZE);
+    visited.insert(visited.end(), chunk.begin(), chunk.end());
+    ++chunks;
+  });
+
+  std::vector<const typename Map<K>::value_type*> iterated;
+  for (const auto& item : map)
+    iterated.push_back(&item);
+  BOOST_CHECK(visited == iterated);
+  BOOST_CHECK_EQUAL(chunks, (map.getSize() + Map<K>::CHUNK_SIZE - 1) / Map<K>::CHUNK_SIZE);
+  Map<K>().forEachChunk([](auto) { BOOST_ERROR("empty map has no chunks"); });
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
@@ -0,0 +1,148 @@
+#include <Workload.h>
+#include <HashMap.h>
+#include <TreeMap.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(WorkloadTests)
+
+BOOST_AUTO_TEST_CASE(GivenSameSeed_WhenGeneratingKeys_ThenStreamsAreEqual)
+{
+  aisdi::KeyStreamConfig config;
+  aisdi::Xoshiro256 first(7), second(7), other(8);
+
+  const auto keys = aisdi::generateKeyStream(config, 1000, first);
+
+  BOOST_CHECK(keys == aisdi::generateKeyStream(config, 1000, second));
+  BOOST_CHECK(keys != aisdi::generateKeyStream(config, 1000, other));
+  for (const auto key : keys)
+    BOOST_CHECK_LT(key, config.keySpace);
+}
+
+BOOST_AUTO_TEST_CASE(GivenOrderedDistributions_WhenGeneratingKeys_ThenKeysFollowThePattern)
+{
+  aisdi::KeyStreamConfig config;
+  config.keySpace = 4;
+  aisdi::Xoshiro256 generator;
+
+  config.distribution = aisdi::KeyDistribution::SEQUENTIAL;
+  BOOST_CHECK(aisdi::generateKeyStream(config, 6, generator) == std::vector<std::uint64_t>({ 0, 1, 2, 3, 0, 1 }));
+  config.distribution = aisdi::KeyDistribution::REVERSE;
+  BOOST_CHECK(aisdi::generateKeyStream(config, 6, generator) == std::vector<std::uint64_t>({ 3, 2, 1, 0, 3, 2 }));
+  config.distribution = aisdi::KeyDistribution::STRIDED;
+  config.stride = 100;
+  BOOST_CHECK(aisdi::generateKeyStream(config, 5, generator) == std::vector<std::uint64_t>({ 0, 100, 200, 300, 0 }));
+}
+
+BOOST_AUTO_TEST_CASE(GivenClusteredDistribution_WhenGeneratingKeys_ThenClustersAreConsecutive)
+{
+  aisdi::KeyStreamConfig config;
+  config.distribution = aisdi::KeyDistribution::CLUSTERED;
+  config.keySpace = 1u << 30;
+  config.clusterSize = 8;
+  aisdi::Xoshiro256 generator;
+
+  const auto keys = aisdi::generateKeyStream(config, 64, generator);
+
+  for (std::size_t i = 0; i < keys.size(); i++)
+    if (i % 8 != 0)
+      BOOST_CHECK_EQUAL(keys[i], keys[i - 1] + 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenZipfDistribution_WhenGeneratingKeys_ThenSmallKeysAreHot)
+{
+  aisdi::KeyStreamConfig config;
+  config.distribution = aisdi::KeyDistribution::ZIPF;
+  config.keySpace = 1000;
+  config.zipfExponent = 1.0;
+  aisdi::Xoshiro256 generator;
+  std::vector<std::size_t> counts(config.keySpace, 0);
+
+  for (const auto key : aisdi::generateKeyStream(config, 100000, generator))
+  {
+    BOOST_REQUIRE_LT(key, config.keySpace);
+    counts[key]++;
+  }
+
+  // P(0) = 1 / H(1000) ~ 0.134, P(1) = P(0) / 2
+  BOOST_CHECK_CLOSE(counts[0] / 100000.0, 0.134, 5);
+  BOOST_CHECK_CLOSE(counts[1] / 100000.0, 0.067, 10);
+  BOOST_CHECK_GT(counts[9], counts[99]);
+}
+
+BOOST_AUTO_TEST_CASE(GivenOperationMix_WhenGeneratingWorkload_ThenProportionsAreKept)
+{
+  aisdi::KeyStreamConfig config;
+  aisdi::OperationMix mix;
+  mix.reads = 70;
+  mix.writes = 20;
+  mix.removes = 10;
+  aisdi::Xoshiro256 generator;
+  std::size_t counts[3] = { 0, 0, 0 };
+
+  for (const auto& operation : aisdi::generateWorkload(config, mix, 100000, generator))
+    counts[static_cast<int>(operation.type)]++;
+
+  BOOST_CHECK_CLOSE(counts[0] / 100000.0, 0.7, 3);
+  BOOST_CHECK_CLOSE(counts[1] / 100000.0, 0.2, 5);
+  BOOST_CHECK_CLOSE(counts[2] / 100000.0, 0.1, 10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMix_WhenGeneratingWorkload_ThenExceptionIsThrown)
+{
+  aisdi::OperationMix mix;
+  mix.reads = 0;
+  aisdi::Xoshiro256 generator;
+
+  BOOST_CHECK_THROW(aisdi::generateWorkload(aisdi::KeyStreamConfig(), mix, 10, generator), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(GivenWorkload_WhenWritingAndReadingTrace_ThenOperationsAreEqual)
+{
+  const std::string path = "aisdi_workload_test.trace";
+  const std::vector<aisdi::Operation> operations = {
+    { aisdi::OperationType::WRITE, 42 }, { aisdi::OperationType::READ, 0xfedcba9876543210ull },
+    { aisdi::OperationType::REMOVE, 42 } };
+
+  aisdi::writeTrace(path, operations);
+  const auto read = aisdi::readTrace(path);
+  std::remove(path.c_str());
+
+  BOOST_REQUIRE_EQUAL(read.size(), operations.size());
+  for (std::size_t i = 0; i < read.size(); i++)
+  {
+    BOOST_CHECK(read[i].type == operations[i].type);
+    BOOST_CHECK_EQUAL(read[i].key, operations[i].key);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingFile_WhenReadingTrace_ThenExceptionIsThrown)
+{
+  BOOST_CHECK_THROW(aisdi::readTrace("no/such/aisdi.trace"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenWorkload_WhenReplayingOnBothMaps_ThenMapsEndEqual)
+{
+  aisdi::KeyStreamConfig config;
+  config.keySpace = 200;
+  aisdi::OperationMix mix;
+  mix.writes = 1;
+  mix.removes = 1;
+  aisdi::Xoshiro256 generator;
+  const auto operations = aisdi::generateWorkload(config, mix, 5000, generator);
+  aisdi::TreeMap<int, int> tree;
+  aisdi::HashMap<int, int> hash;
+
+  BOOST_CHECK_EQUAL(aisdi::replay(tree, operations), aisdi::replay(hash, operations));
+
+  BOOST_REQUIRE_EQUAL(tree.getSize(), hash.getSize());
+  for (const auto& item : tree)
+    BOOST_CHECK(hash.tryGet(item.first) != nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()